@@ -15,13 +15,15 @@ using namespace nu;
 constexpr uint32_t kNumThreads = 18;
 constexpr uint32_t kTargetMops = 2;
 constexpr uint64_t kPerfDurationUs = 10 * kOneSecond;
-constexpr uint32_t kNumProclets = 65566;
+constexpr uint32_t kNumProclets = 32768;
+constexpr uint32_t kNumProcletsPerAllocation = 1024;
+constexpr uint64_t kProcletCapacity = kMinProcletHeapSize;
 
 namespace nu {
 
 struct PerfResolveObjThreadState : PerfThreadState {
   PerfResolveObjThreadState()
-      : rd(), gen(rd()), dist_proclet_num(1, kNumProclets) {}
+      : rd(), gen(rd()), dist_proclet_num(0, kNumProclets - 1) {}
 
   std::random_device rd;
   std::mt19937 gen;
@@ -36,7 +38,9 @@ struct PerfResolveObjReq : PerfRequest {
 
 class PerfResolveObjAdapter : public PerfAdapter {
  public:
-  PerfResolveObjAdapter(ControllerClient *client) : client_(client) {}
+  PerfResolveObjAdapter(ControllerClient *client,
+                        const std::vector<ProcletAllocation> &allocations)
+      : client_(client), allocations_(allocations) {}
 
   std::unique_ptr<PerfThreadState> create_thread_state() {
     return std::make_unique<PerfResolveObjThreadState>();
@@ -50,15 +54,14 @@ class PerfResolveObjAdapter : public PerfAdapter {
 
   bool serve_req(PerfThreadState *perf_state, const PerfRequest *perf_req) {
     auto *req = reinterpret_cast<const PerfResolveObjReq *>(perf_req);
-    ProcletID proclet_id =
-        kMaxProcletHeapVAddr - req->proclet_num * kMaxProcletHeapSize;
-    auto ip = client_->resolve_proclet(proclet_id);
+    auto ip = client_->resolve_proclet(allocations_[req->proclet_num].id);
     BUG_ON(!ip);
     return true;
   }
 
  private:
   ControllerClient *client_;
+  const std::vector<ProcletAllocation> &allocations_;
 };
 
 class PerfAcquireMigrationDestAdapter : public PerfAdapter {
@@ -86,7 +89,7 @@ class PerfAcquireMigrationDestAdapter : public PerfAdapter {
 
 struct PerfUpdateLocationThreadState : PerfThreadState {
   PerfUpdateLocationThreadState()
-      : rd(), gen(rd()), dist_proclet_num(1, kNumProclets) {}
+      : rd(), gen(rd()), dist_proclet_num(0, kNumProclets - 1) {}
 
   std::random_device rd;
   std::mt19937 gen;
@@ -101,7 +104,9 @@ struct PerfUpdateLocationReq : PerfRequest {
 
 class PerfUpdateLocationAdapter : public PerfAdapter {
  public:
-  PerfUpdateLocationAdapter(ControllerClient *client) : client_(client) {}
+  PerfUpdateLocationAdapter(ControllerClient *client,
+                            const std::vector<ProcletAllocation> &allocations)
+      : client_(client), allocations_(allocations) {}
 
   std::unique_ptr<PerfThreadState> create_thread_state() {
     return std::make_unique<PerfUpdateLocationThreadState>();
@@ -115,24 +120,35 @@ class PerfUpdateLocationAdapter : public PerfAdapter {
 
   bool serve_req(PerfThreadState *perf_state, const PerfRequest *perf_req) {
     auto *req = reinterpret_cast<const PerfUpdateLocationReq *>(perf_req);
-    ProcletID proclet_id =
-        kMaxProcletHeapVAddr - req->proclet_num * kMaxProcletHeapSize;
-    client_->update_location(proclet_id, get_cfg_ip());
+    auto &allocation = allocations_[req->proclet_num];
+    // Carries the generation the controller handed out, so the update gets
+    // applied rather than dropped as stale.
+    ProcletLocation location;
+    location.ip = allocation.ip;
+    location.epoch = 1;
+    ProcletLocationUpdate update;
+    update.id = allocation.id;
+    update.location_raw = location.raw;
+    update.generation = allocation.generation;
+    client_->update_locations(std::span(&update, 1));
     return true;
   }
 
  private:
   ControllerClient *client_;
+  const std::vector<ProcletAllocation> &allocations_;
 };
 
 class Test {
  public:
   void run() {
+    auto *client = get_runtime()->controller_client();
+    allocate(client);
+
     {
       rt::Preempt p;
       rt::PreemptGuard g(&p);
-      PerfResolveObjAdapter perf_resolve_obj_adapter(
-          get_runtime()->controller_client());
+      PerfResolveObjAdapter perf_resolve_obj_adapter(client, allocations_);
       Perf perf(perf_resolve_obj_adapter);
       perf.run(kNumThreads, kTargetMops, kPerfDurationUs);
       std::cout << "resolve_obj() mops = " << perf.get_real_mops() << std::endl;
@@ -142,7 +158,7 @@ class Test {
       rt::Preempt p;
       rt::PreemptGuard g(&p);
       PerfAcquireMigrationDestAdapter perf_acquire_migration_dest_adapter(
-          get_runtime()->controller_client());
+          client);
       Perf perf(perf_acquire_migration_dest_adapter);
       perf.run(kNumThreads, kTargetMops, kPerfDurationUs);
       std::cout << "acquire_migration_obj() mops = " << perf.get_real_mops()
@@ -152,16 +168,33 @@ class Test {
     {
       rt::Preempt p;
       rt::PreemptGuard g(&p);
-      PerfUpdateLocationAdapter perf_update_location_adapter(
-          get_runtime()->controller_client());
+      PerfUpdateLocationAdapter perf_update_location_adapter(client,
+                                                             allocations_);
       Perf perf(perf_update_location_adapter);
       perf.run(kNumThreads, kTargetMops, kPerfDurationUs);
       std::cout << "update_location() mops = " << perf.get_real_mops()
                 << std::endl;
     }
+
+    for (auto &allocation : allocations_) {
+      client->destroy_proclet(VAddrRange{
+          .start = allocation.id, .end = allocation.id + kProcletCapacity});
+    }
   }
 
  private:
+  std::vector<ProcletAllocation> allocations_;
+
+  void allocate(ControllerClient *client) {
+    allocations_.reserve(kNumProclets);
+    while (allocations_.size() < kNumProclets) {
+      auto allocated = client->allocate_proclets(
+          kProcletCapacity, get_cfg_ip(), kNumProcletsPerAllocation);
+      BUG_ON(allocated.empty());
+      allocations_.insert(allocations_.end(), allocated.begin(),
+                          allocated.end());
+    }
+  }
 };
 
 }  // namespace nu
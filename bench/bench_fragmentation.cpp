@@ -16,7 +16,9 @@ extern "C" {
 #include <runtime.h>
 
 #include "nu/dis_hash_table.hpp"
+#include "nu/migrator.hpp"
 #include "nu/proclet.hpp"
+#include "nu/proclet_mgr.hpp"
 #include "nu/runtime.hpp"
 #include "nu/utils/farmhash.hpp"
 #include "nu/utils/trace_logger.hpp"
@@ -73,6 +75,28 @@ struct Test {
     rt::PreemptGuard g(&p);
     return get_runtime()->proclet_manager()->get_mem_usage();
   }
+  // Bytes that migrating the local proclets would send, before and after
+  // skipping the free slab regions.
+  std::pair<uint64_t, uint64_t> get_migration_bytes() {
+    rt::Preempt p;
+    rt::PreemptGuard g(&p);
+    uint64_t high_water = 0, live = 0;
+    auto proclets = get_runtime()->proclet_manager()->get_all_proclets();
+    for (auto *proclet_base : proclets) {
+      auto *header = reinterpret_cast<ProcletHeader *>(proclet_base);
+      auto len = reinterpret_cast<uint64_t>(header->slab.get_base()) +
+                 header->slab.get_usage() -
+                 reinterpret_cast<uint64_t>(header->copy_start);
+      high_water += len;
+      live += len;
+      auto free_regions = header->slab.get_free_regions(
+          Migrator::kMinSkippedFreeRegionSize);
+      for (auto [start, end] : free_regions) {
+        live -= end - start;
+      }
+    }
+    return std::make_pair(high_water, live);
+  }
 };
 }  // namespace nu
 
@@ -223,6 +247,9 @@ uint64_t run_on_dis_hash_table(std::vector<Command> *commands) {
   }
 
   auto mem_usage_end = test.run(&nu::Test::get_mem_usage);
+  auto [high_water, live] = test.run(&nu::Test::get_migration_bytes);
+  std::cout << "migration bytes: high_water = " << high_water
+            << ", live = " << live << std::endl;
   return mem_usage_end - mem_usage_start;
 }
 
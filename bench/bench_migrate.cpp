@@ -17,12 +17,15 @@ extern "C" {
 
 using namespace nu;
 
-constexpr uint32_t kObjSize = 128 << 10;
+constexpr uint64_t kHeapSizes[] = {128 << 10, 16 << 20, 64 << 20, 256 << 20,
+                                   512 << 20};
 constexpr uint32_t kNumRuns = 5;
+constexpr uint32_t kMeasureUs = 1500 * 1000;
 
 namespace nu {
 class Test {
  public:
+  Test(uint64_t heap_size) : heap_(heap_size, 1) {}
   void run() {
     {
       rt::Preempt p;
@@ -31,18 +34,38 @@ class Test {
     }
     delay_ms(1000);
   }
+  // Keeps dirtying the heap while it is being migrated.
+  void touch(uint64_t idx) { heap_[idx % heap_.size()]++; }
 
  private:
-  uint8_t heap[kObjSize];
+  std::vector<uint8_t> heap_;
 };
 }  // namespace nu
 
 int main(int argc, char **argv) {
   return runtime_main_init(argc, argv, [](int, char **) {
-    for (uint32_t k = 0; k < kNumRuns; k++) {
-      auto proclet = make_proclet<Test>();
-      proclet.run(&Test::run);
-      delay_ms(100);
+    std::cout << "heap_size max_call_latency_us" << std::endl;
+    for (auto heap_size : kHeapSizes) {
+      std::vector<uint64_t> max_latencies;
+      for (uint32_t k = 0; k < kNumRuns; k++) {
+        auto proclet = make_proclet<Test>(std::make_tuple(heap_size));
+        auto future = proclet.run_async(&Test::run);
+
+        // The longest call latency approximates the pause time.
+        uint64_t max_latency_us = 0;
+        auto start_us = microtime();
+        for (uint64_t i = 0; microtime() - start_us < kMeasureUs; i++) {
+          auto t0 = microtime();
+          proclet.run(&Test::touch, i * kPageSize);
+          max_latency_us = std::max(max_latency_us, microtime() - t0);
+        }
+        future.get();
+        max_latencies.push_back(max_latency_us);
+        delay_ms(100);
+      }
+      std::sort(max_latencies.begin(), max_latencies.end());
+      std::cout << heap_size << " " << max_latencies[kNumRuns / 2]
+                << std::endl;
     }
   });
 }
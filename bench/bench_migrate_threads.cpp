@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+extern "C" {
+#include <base/time.h>
+#include <net/ip.h>
+#include <runtime/runtime.h>
+}
+#include <runtime.h>
+
+#include "nu/pressure_handler.hpp"
+#include "nu/proclet.hpp"
+#include "nu/runtime.hpp"
+#include "nu/utils/cond_var.hpp"
+#include "nu/utils/mutex.hpp"
+#include "nu/utils/thread.hpp"
+
+using namespace nu;
+
+constexpr uint32_t kNumParkedThreads[] = {0, 1000, 10000};
+constexpr uint32_t kNumRuns = 5;
+constexpr uint32_t kMeasureUs = 1500 * 1000;
+
+namespace nu {
+class Test {
+ public:
+  // Parks num threads on a condvar, as blocked request handlers would be.
+  void park(uint32_t num) {
+    for (uint32_t i = 0; i < num; i++) {
+      threads_.emplace_back([&] {
+        mutex_.lock();
+        num_parked_++;
+        while (!rt::access_once(released_)) {
+          condvar_.wait(&mutex_);
+        }
+        mutex_.unlock();
+      });
+    }
+    while (rt::access_once(num_parked_) < num) {
+      timer_sleep(100);
+    }
+  }
+
+  void run() {
+    {
+      rt::Preempt p;
+      rt::PreemptGuard g(&p);
+      get_runtime()->pressure_handler()->mock_set_pressure();
+    }
+    delay_ms(1000);
+  }
+
+  void ping() {}
+
+  void release() {
+    mutex_.lock();
+    released_ = true;
+    condvar_.signal_all();
+    mutex_.unlock();
+    for (auto &thread : threads_) {
+      thread.join();
+    }
+  }
+
+ private:
+  std::vector<Thread> threads_;
+  Mutex mutex_;
+  CondVar condvar_;
+  uint32_t num_parked_ = 0;
+  bool released_ = false;
+};
+}  // namespace nu
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    std::cout << "num_parked_threads max_call_latency_us" << std::endl;
+    for (auto num_threads : kNumParkedThreads) {
+      std::vector<uint64_t> max_latencies;
+      for (uint32_t k = 0; k < kNumRuns; k++) {
+        auto proclet = make_proclet<Test>();
+        proclet.run(&Test::park, num_threads);
+        auto future = proclet.run_async(&Test::run);
+
+        // The longest call latency approximates the pause time.
+        uint64_t max_latency_us = 0;
+        auto start_us = microtime();
+        while (microtime() - start_us < kMeasureUs) {
+          auto t0 = microtime();
+          proclet.run(&Test::ping);
+          max_latency_us = std::max(max_latency_us, microtime() - t0);
+        }
+        future.get();
+        proclet.run(&Test::release);
+        max_latencies.push_back(max_latency_us);
+        delay_ms(100);
+      }
+      std::sort(max_latencies.begin(), max_latencies.end());
+      std::cout << num_threads << " " << max_latencies[kNumRuns / 2]
+                << std::endl;
+    }
+  });
+}
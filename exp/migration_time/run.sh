@@ -7,8 +7,12 @@ LPID=1
 SRC_SRV_IDX=1
 DEST_SRV_IDX=2
 
+for precopy in false true
+do
+
 pushd $NU_DIR
 sed "s/\(constexpr static bool kEnableLogging =\).*/\1 true;/g" -i src/migrator.cpp
+sed "s/\(constexpr static bool kEnablePreCopy =\).*/\1 $precopy;/g" -i inc/nu/migrator.hpp
 make -j
 popd
 
@@ -28,8 +32,8 @@ do
     start_ctrl $SRC_SRV_IDX
     sleep 5
 
-    start_server main $SRC_SRV_IDX $LPID 1>logs/$heap_size.src 2>&1 &
-    start_server main $DEST_SRV_IDX $LPID 1>logs/$heap_size.dest 2>&1 &
+    start_server main $SRC_SRV_IDX $LPID 1>logs/$precopy.$heap_size.src 2>&1 &
+    start_server main $DEST_SRV_IDX $LPID 1>logs/$precopy.$heap_size.dest 2>&1 &
     sleep 5
 
     start_client main $SRC_SRV_IDX $LPID
@@ -38,7 +42,13 @@ do
     sleep 5
 done
 
+# The source logs report the pause time of every migrated proclet.
+grep -h "Pause proclet" logs/$precopy.*.src > logs/$precopy.pause
+
+done
+
 pushd $NU_DIR
 sed "s/\(constexpr static bool kEnableLogging =\).*/\1 false;/g" -i src/migrator.cpp
+sed "s/\(constexpr static bool kEnablePreCopy =\).*/\1 true;/g" -i inc/nu/migrator.hpp
 make -j
 popd
@@ -23,6 +23,10 @@ struct OptionsDesc {
 struct NuOptionsDesc : public OptionsDesc {
   std::string ctrl_ip_str;
   lpid_t lpid;
+  float migration_bw_gbs;
+  std::string migration_trace_path;
+  std::string spill_dir;
+  std::string checkpoint_dir;
   
 #ifdef DDB_SUPPORT
   std::string ddb_addr;
@@ -40,6 +40,31 @@ struct VAddrRange {
   }
 };
 
+union ProcletLocation {  // Supports atomic assignment.
+  struct {
+    NodeIP ip;
+    // Bumped by every migration so that stale locations can be told apart.
+    // Zero means unknown.
+    uint16_t epoch;
+  };
+  uint64_t raw = 0;
+
+  ProcletLocation &operator=(const ProcletLocation &o) {
+    raw = o.raw;
+    return *this;
+  }
+  bool is_newer_than(const ProcletLocation &o) const;
+};
+static_assert(sizeof(ProcletLocation) == sizeof(ProcletLocation::raw));
+
+// A heap segment handed out by the controller. The generation tells apart the
+// proclets that successively occupy the segment.
+struct ProcletAllocation {
+  ProcletID id;
+  NodeIP ip;
+  uint32_t generation;
+};
+
 template <typename T>
 union MethodPtr {
   T ptr;
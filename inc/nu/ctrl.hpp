@@ -5,8 +5,10 @@
 #include <list>
 #include <map>
 #include <set>
+#include <span>
 #include <stack>
 #include <utility>
+#include <vector>
 
 extern "C" {
 #include <runtime/net.h>
@@ -23,6 +25,13 @@ extern "C" {
 
 namespace nu {
 
+struct ProcletLocationUpdate {
+  ProcletID id;
+  uint64_t location_raw;  // ProcletLocation is non-POD, so it cannot be packed.
+  // Updates of an earlier proclet on the same segment are dropped.
+  uint32_t generation;
+} __attribute__((packed));
+
 // This is a logical node instead of a physical node.
 struct NodeStatus {
   constexpr static uint32_t kMovingMinWinTimeUs = IAS_PS_CPU_THRESH_US;
@@ -57,6 +66,11 @@ struct LPInfo {
   LPInfo();
 };
 
+struct ProcletRecord {
+  ProcletLocation location;
+  uint32_t generation;
+};
+
 struct ProcletHeapSegment {
   VAddrRange range;
   NodeIP prev_host;
@@ -71,8 +85,17 @@ class Controller {
   std::optional<std::pair<lpid_t, VAddrRange>> register_node(
       NodeIP ip, lpid_t lpid, MD5Val md5, bool main, bool isol);
   void destroy_lp(lpid_t lpid, NodeIP requestor_ip);
-  std::optional<std::pair<ProcletID, NodeIP>> allocate_proclet(
-      uint64_t capacity, lpid_t lpid, NodeIP ip_hint);
+  std::optional<ProcletAllocation> allocate_proclet(uint64_t capacity,
+                                                    lpid_t lpid,
+                                                    NodeIP ip_hint);
+  std::vector<ProcletAllocation> allocate_proclets(uint64_t capacity,
+                                                   lpid_t lpid, NodeIP ip_hint,
+                                                   uint32_t num);
+  // Allocates the given segment to the node, e.g., to restore a checkpointed
+  // proclet at its original address. Fails if it is not free; returns the
+  // generation otherwise.
+  std::optional<uint32_t> claim_proclet(ProcletID id, uint64_t capacity,
+                                        lpid_t lpid, NodeIP ip);
   void destroy_proclet(VAddrRange heap_segment);
   NodeIP resolve_proclet(ProcletID id);
   std::pair<NodeIP, Resource> acquire_migration_dest(lpid_t lpid,
@@ -81,7 +104,7 @@ class Controller {
                                                      Resource resource);
   bool acquire_node(lpid_t lpid, NodeIP ip);
   void release_node(lpid_t lpid, NodeIP ip);
-  void update_location(ProcletID id, NodeIP proclet_srv_ip);
+  void update_locations(std::span<const ProcletLocationUpdate> updates);
   std::vector<std::pair<NodeIP, Resource>> report_free_resource(
       lpid_t lpid, NodeIP ip, Resource free_resource);
 
@@ -94,10 +117,15 @@ class Controller {
   std::set<lpid_t> free_lpids_;
   std::map<lpid_t, MD5Val> lpid_to_md5_;
   std::map<lpid_t, LPInfo> lpid_to_info_;
-  std::map<ProcletID, NodeIP> proclet_id_to_ip_;
+  std::map<ProcletID, ProcletRecord> proclet_id_to_record_;
+  uint32_t next_generation_;
   bool done_;
   Mutex mutex_;
 
+  std::optional<ProcletAllocation> __allocate_proclet(uint64_t capacity,
+                                                      lpid_t lpid,
+                                                      NodeIP ip_hint);
+  void __destroy_proclet(VAddrRange heap_segment);
   NodeIP select_node_for_proclet(lpid_t lpid, NodeIP ip_hint,
                                  const ProcletHeapSegment &segment);
   bool update_node(std::set<Node>::iterator iter);
@@ -45,14 +45,20 @@ class ControllerClient {
                                                              MD5Val md5,
                                                              bool main,
                                                              bool isol);
-  std::optional<std::pair<ProcletID, NodeIP>> allocate_proclet(
-      uint64_t capacity, NodeIP ip_hint);
+  std::optional<ProcletAllocation> allocate_proclet(uint64_t capacity,
+                                                    NodeIP ip_hint);
+  // Either all num proclets get allocated or none does.
+  std::vector<ProcletAllocation> allocate_proclets(uint64_t capacity,
+                                                   NodeIP ip_hint,
+                                                   uint32_t num);
+  // Returns the generation of the claimed segment on success.
+  std::optional<uint32_t> claim_proclet(ProcletID id, uint64_t capacity);
   void destroy_proclet(VAddrRange heap_segment);
   NodeIP resolve_proclet(ProcletID id);
   NodeGuard acquire_node();
   std::pair<NodeGuard, Resource> acquire_migration_dest(bool has_mem_pressure,
                                                         Resource resource);
-  void update_location(ProcletID id, NodeIP proclet_srv_ip);
+  void update_locations(std::span<const ProcletLocationUpdate> updates);
   VAddrRange get_stack_cluster() const;
   std::vector<std::pair<NodeIP, Resource>> report_free_resource(
       Resource resource);
@@ -40,10 +40,32 @@ struct RPCReqAllocateProclet {
   NodeIP ip_hint;
 } __attribute__((packed));
 
+struct RPCReqAllocateProclets {
+  RPCReqType rpc_type = kAllocateProclets;
+  uint64_t capacity;
+  lpid_t lpid;
+  NodeIP ip_hint;
+  uint32_t num;
+} __attribute__((packed));
+
 struct RPCRespAllocateProclet {
   bool empty;
   ProcletID id;
   NodeIP server_ip;
+  uint32_t generation;
+} __attribute__((packed));
+
+struct RPCReqClaimProclet {
+  RPCReqType rpc_type = kClaimProclet;
+  ProcletID id;
+  uint64_t capacity;
+  lpid_t lpid;
+  NodeIP ip;
+} __attribute__((packed));
+
+struct RPCRespClaimProclet {
+  bool succeed;
+  uint32_t generation;
 } __attribute__((packed));
 
 struct RPCReqDestroyProclet {
@@ -60,10 +82,10 @@ struct RPCRespResolveProclet {
   NodeIP ip;
 } __attribute__((packed));
 
-struct RPCReqUpdateLocation {
-  RPCReqType rpc_type = kUpdateLocation;
-  ProcletID id;
-  NodeIP proclet_srv_ip;
+// Followed by num ProcletLocationUpdate entries.
+struct RPCReqUpdateLocations {
+  RPCReqType rpc_type = kUpdateLocations;
+  uint32_t num;
 } __attribute__((packed));
 
 struct RPCReqAcquireMigrationDest {
@@ -124,6 +146,7 @@ class ControllerServer {
   Controller ctrl_;
   std::atomic<uint64_t> num_register_node_;
   std::atomic<uint64_t> num_allocate_proclet_;
+  std::atomic<uint64_t> num_claim_proclet_;
   std::atomic<uint64_t> num_destroy_proclet_;
   std::atomic<uint64_t> num_resolve_proclet_;
   std::atomic<uint64_t> num_acquire_migration_dest_;
@@ -143,6 +166,10 @@ class ControllerServer {
       const RPCReqRegisterNode &req);
   std::unique_ptr<RPCRespAllocateProclet> handle_allocate_proclet(
       const RPCReqAllocateProclet &req);
+  std::vector<ProcletAllocation> handle_allocate_proclets(
+      const RPCReqAllocateProclets &req);
+  std::unique_ptr<RPCRespClaimProclet> handle_claim_proclet(
+      const RPCReqClaimProclet &req);
   void handle_destroy_proclet(const RPCReqDestroyProclet &req);
   std::unique_ptr<RPCRespResolveProclet> handle_resolve_proclet(
       const RPCReqResolveProclet &req);
@@ -150,7 +177,8 @@ class ControllerServer {
       const RPCReqAcquireMigrationDest &req);
   RPCRespAcquireNode handle_acquire_node(const RPCReqAcquireNode &req);
   void handle_release_node(const RPCReqReleaseNode &req);
-  void handle_update_location(const RPCReqUpdateLocation &req);
+  void handle_update_locations(
+      std::span<const ProcletLocationUpdate> updates);
   std::vector<std::pair<NodeIP, Resource>> handle_report_free_resource(
       const RPCReqReportFreeResource &req);
   void handle_destroy_lp(const RPCReqDestroyLP &req);
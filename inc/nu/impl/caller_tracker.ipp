@@ -0,0 +1,36 @@
+namespace nu {
+
+inline CallerTracker::CallerTracker() { reset(); }
+
+inline void CallerTracker::record(NodeIP ip) {
+  // The common case is a hit, which only takes a few relaxed loads.
+  for (auto &slot : ips_) {
+    if (slot.load(std::memory_order_relaxed) == ip) {
+      return;
+    }
+  }
+  // Evict in a round-robin manner. Races may lose an entry, which is fine as
+  // the tracker is only a hint.
+  auto idx = next_slot_.fetch_add(1, std::memory_order_relaxed) % kNumSlots;
+  ips_[idx].store(ip, std::memory_order_relaxed);
+}
+
+inline std::vector<NodeIP> CallerTracker::get_all() const {
+  std::vector<NodeIP> ips;
+  for (auto &slot : ips_) {
+    auto ip = slot.load(std::memory_order_relaxed);
+    if (ip) {
+      ips.push_back(ip);
+    }
+  }
+  return ips;
+}
+
+inline void CallerTracker::reset() {
+  for (auto &slot : ips_) {
+    slot.store(0, std::memory_order_relaxed);
+  }
+  next_slot_.store(0, std::memory_order_relaxed);
+}
+
+}  // namespace nu
@@ -9,6 +9,17 @@ namespace nu {
 
 inline constexpr uint64_t bsr_64(uint64_t a) { return 63 - __builtin_clzll(a); }
 
+inline bool ProcletLocation::is_newer_than(const ProcletLocation &o) const {
+  if (!epoch) {
+    return false;
+  }
+  if (!o.epoch) {
+    return true;
+  }
+  // Tolerates wraparounds.
+  return static_cast<int16_t>(epoch - o.epoch) > 0;
+}
+
 inline constexpr ProcletHeader *to_proclet_header(ProcletID id) {
   return reinterpret_cast<ProcletHeader *>(id);
 }
@@ -0,0 +1,99 @@
+#include <cstring>
+
+extern "C" {
+#include <base/compiler.h>
+#include <base/time.h>
+}
+
+#include "nu/type_traits.hpp"
+
+namespace nu {
+
+inline uint64_t InvocationStats::MethodStats::num_calls() const {
+  return execution.count;
+}
+
+inline double InvocationStats::MethodStats::calls_per_sec() const {
+  return duration_us ? num_calls() * 1e6 / duration_us : 0;
+}
+
+inline InvocationStats::InvocationStats() {
+  for (auto &entry : entries_) {
+    entry.method.store(0, std::memory_order_relaxed);
+  }
+  reset_us_.store(microtime(), std::memory_order_relaxed);
+}
+
+inline InvocationStats::Entry *InvocationStats::get_entry(uintptr_t method) {
+  auto start = (method >> 4) % kMaxNumMethods;
+  for (uint32_t i = 0; i < kMaxNumMethods; i++) {
+    auto &entry = entries_[(start + i) % kMaxNumMethods];
+    auto cur = entry.method.load(std::memory_order_acquire);
+    if (likely(cur == method)) {
+      return &entry;
+    }
+    if (!cur) {
+      if (entry.method.compare_exchange_strong(cur, method,
+                                               std::memory_order_acq_rel) ||
+          cur == method) {
+        return &entry;
+      }
+    }
+  }
+  return nullptr;
+}
+
+inline std::vector<InvocationStats::MethodStats> InvocationStats::get_all()
+    const {
+  auto duration_us = microtime() - reset_us_.load(std::memory_order_relaxed);
+
+  std::vector<MethodStats> all;
+  for (auto &entry : entries_) {
+    auto method = entry.method.load(std::memory_order_acquire);
+    if (method) {
+      auto &stats = all.emplace_back();
+      stats.method = method;
+      stats.duration_us = duration_us;
+      stats.queueing = entry.queueing.snapshot();
+      stats.execution = entry.execution.snapshot();
+      stats.serialization = entry.serialization.snapshot();
+    }
+  }
+  return all;
+}
+
+inline void InvocationStats::reset() {
+  for (auto &entry : entries_) {
+    entry.queueing.reset();
+    entry.execution.reset();
+    entry.serialization.reset();
+  }
+  reset_us_.store(microtime(), std::memory_order_relaxed);
+}
+
+template <typename Fn>
+inline uintptr_t InvocationStats::to_method_key(Fn fn) {
+  if constexpr (std::is_member_function_pointer_v<Fn>) {
+    uintptr_t key;
+    std::memcpy(&key, &fn, sizeof(key));
+    return key;
+  } else {
+    return reinterpret_cast<uintptr_t>(fn);
+  }
+}
+
+template <typename FnPtr, typename... Ss>
+inline uintptr_t InvocationStats::to_method_key(
+    FnPtr fn, const std::tuple<Ss...> &states) {
+  if constexpr (sizeof...(Ss) > 0) {
+    using S0 = std::decay_t<std::tuple_element_t<0, std::tuple<Ss...>>>;
+    // Method invocations are wrapped into closures taking the method pointers
+    // as their first states.
+    if constexpr (is_specialization_of_v<S0, MethodPtr>) {
+      return to_method_key(std::get<0>(states).ptr);
+    }
+  }
+  return to_method_key(fn);
+}
+
+}  // namespace nu
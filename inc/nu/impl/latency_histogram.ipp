@@ -0,0 +1,59 @@
+#include <algorithm>
+
+extern "C" {
+#include <base/time.h>
+}
+
+#include "nu/commons.hpp"
+
+namespace nu {
+
+inline LatencyHistogram::LatencyHistogram() { reset(); }
+
+inline void LatencyHistogram::add(uint64_t duration_tsc) {
+  add_ns(duration_tsc * 1000 / cycles_per_us);
+}
+
+inline void LatencyHistogram::add_ns(uint64_t duration_ns) {
+  uint32_t idx = duration_ns ? std::min<uint64_t>(bsr_64(duration_ns),
+                                                  kNumBuckets - 1)
+                              : 0;
+  buckets_[idx].fetch_add(1, std::memory_order_relaxed);
+  sum_ns_.fetch_add(duration_ns, std::memory_order_relaxed);
+}
+
+inline LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+  Snapshot snapshot;
+  snapshot.count = 0;
+  for (uint32_t i = 0; i < kNumBuckets; i++) {
+    snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.buckets[i];
+  }
+  snapshot.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+inline void LatencyHistogram::reset() {
+  for (auto &bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+  sum_ns_.store(0, std::memory_order_relaxed);
+}
+
+inline uint64_t LatencyHistogram::Snapshot::mean_ns() const {
+  return count ? sum_ns / count : 0;
+}
+
+inline uint64_t LatencyHistogram::Snapshot::percentile_ns(double p) const {
+  auto target = static_cast<uint64_t>(count * p / 100);
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < kNumBuckets; i++) {
+    seen += buckets[i];
+    if (seen > target) {
+      return (2ULL << i) - 1;
+    }
+  }
+  return count ? (2ULL << (kNumBuckets - 1)) - 1 : 0;
+}
+
+}  // namespace nu
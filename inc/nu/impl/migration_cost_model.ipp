@@ -0,0 +1,11 @@
+namespace nu {
+
+inline float MigrationCostModel::Params::estimate_us(uint64_t bytes) const {
+  return fixed_cost_us + bytes / bytes_per_us;
+}
+
+inline float MigrationCostModel::Params::get_bw_gbps() const {
+  return bytes_per_us * 8 / 1000;
+}
+
+}  // namespace nu
@@ -0,0 +1,40 @@
+extern "C" {
+#include <base/time.h>
+}
+
+namespace nu {
+
+inline void MigrationRecord::add(MigrationSpan::Phase phase,
+                                 uint64_t start_tsc, uint64_t end_tsc,
+                                 ProcletID proclet_id, uint32_t lane) {
+  spans.push_back(MigrationSpan{.phase = phase,
+                                .lane = lane,
+                                .proclet_id = proclet_id,
+                                .start_tsc = start_tsc,
+                                .end_tsc = end_tsc});
+}
+
+inline void MigrationTracer::enable() { enabled_ = true; }
+
+inline bool MigrationTracer::is_enabled() const { return enabled_; }
+
+inline uint64_t MigrationTracer::get_num_finished_records() const {
+  return rt::access_once(num_finished_records_);
+}
+
+inline MigrationSpanGuard::MigrationSpanGuard(MigrationRecord *record,
+                                              MigrationSpan::Phase phase,
+                                              ProcletID proclet_id)
+    : record_(record), phase_(phase), proclet_id_(proclet_id) {
+  if (record_) {
+    start_tsc_ = rdtsc();
+  }
+}
+
+inline MigrationSpanGuard::~MigrationSpanGuard() {
+  if (record_) {
+    record_->add(phase_, start_tsc_, rdtsc(), proclet_id_);
+  }
+}
+
+}  // namespace nu
@@ -5,6 +5,29 @@
 
 namespace nu {
 
+template <std::size_t Extent>
+inline ssize_t MigrationBatchWriter::WritevFull(
+    std::span<const iovec, Extent> iov, bool nt, bool poll) {
+  ssize_t len = 0;
+  for (auto &[base, iov_len] : iov) {
+    WriteFull(base, iov_len, nt, poll);
+    len += iov_len;
+  }
+  return len;
+}
+
+inline void Migrator::report_foreground_latency(uint64_t latency_tsc) {
+  // Only tracked while migrations are being throttled.
+  if (likely(!num_budgeted_transfers_.load(std::memory_order_relaxed))) {
+    return;
+  }
+  // Reported by many threads at once.
+  auto old = foreground_latency_tsc_.load(std::memory_order_relaxed);
+  while (!foreground_latency_tsc_.compare_exchange_weak(
+      old, old - old / 8 + latency_tsc / 8, std::memory_order_relaxed)) {
+  }
+}
+
 template <typename RetT>
 RPCReturnCode Migrator::load_thread_and_ret_val(ProcletHeader *dest_header,
                                                 void *raw_dest_ret_val_ptr,
@@ -114,4 +137,8 @@ inline MigrationGuard Migrator::migrate_thread_and_ret_val(
   return MigrationGuard();
 }
 
+inline MigrationTracer *Migrator::tracer() { return &tracer_; }
+
+inline MigrationCostModel *Migrator::cost_model() { return &cost_model_; }
+
 }  // namespace nu
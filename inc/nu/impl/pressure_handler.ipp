@@ -14,6 +14,16 @@ inline bool PressureHandler::has_pressure() {
   return has_cpu_pressure() || has_mem_pressure();
 }
 
+inline uint32_t PressureHandler::get_num_aux_handlers() const {
+  return num_aux_handlers_;
+}
+
+inline std::pair<uint64_t, uint64_t> PressureHandler::get_aux_task_tsc(
+    uint32_t handler_id) const {
+  auto &state = aux_handler_states_[handler_id];
+  return std::make_pair(state.task_start_tsc, state.task_end_tsc);
+}
+
 inline bool PressureHandler::has_real_pressure() {
   return has_pressure() && !mock_;
 }
@@ -3,10 +3,12 @@
 #include <array>
 #include <concepts>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <sstream>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 extern "C" {
 #include <base/assert.h>
@@ -49,7 +51,7 @@ inline void serialize(auto *oa_sstream, S1s &&...states) {
 }
 
 template <typename T>
-template <typename... S1s>
+template <RPCPriority Prio, typename... S1s>
 void Proclet<T>::invoke_remote(MigrationGuard &&caller_guard, ProcletID id,
                                S1s &&...states) {
   std::optional<MigrationGuard> optional_caller_guard;
@@ -71,9 +73,9 @@ retry:
   auto args_span = std::span(states_data, states_size);
 
   auto *client = get_runtime()->rpc_client_mgr()->get_by_proclet_id(id);
-  rc = client->Call(args_span, &return_buf);
+  rc = client->Call(args_span, &return_buf, Prio);
   if (unlikely(rc == kErrWrongClient)) {
-    get_runtime()->rpc_client_mgr()->invalidate_cache(id, client);
+    get_runtime()->rpc_client_mgr()->invalidate_cache(id, client, return_buf);
     goto retry;
   }
   assert(rc == kOk);
@@ -88,7 +90,7 @@ retry:
 }
 
 template <typename T>
-template <typename RetT, typename... S1s>
+template <typename RetT, RPCPriority Prio, typename... S1s>
 RetT Proclet<T>::invoke_remote_with_ret(MigrationGuard &&caller_guard,
                                         ProcletID id, S1s &&...states) {
   RetT ret;
@@ -111,9 +113,9 @@ retry:
   auto args_span = std::span(states_data, states_size);
 
   auto *client = get_runtime()->rpc_client_mgr()->get_by_proclet_id(id);
-  rc = client->Call(args_span, &return_buf);
+  rc = client->Call(args_span, &return_buf, Prio);
   if (unlikely(rc == kErrWrongClient)) {
-    get_runtime()->rpc_client_mgr()->invalidate_cache(id, client);
+    get_runtime()->rpc_client_mgr()->invalidate_cache(id, client, return_buf);
     goto retry;
   }
   assert(rc == kOk);
@@ -190,6 +192,7 @@ Proclet<T> Proclet<T>::__create(bool pinned, uint64_t capacity, NodeIP ip_hint,
                                 As &&...args) {
   uint32_t server_ip;
   ProcletID callee_id;
+  uint32_t generation;
   Proclet<T> callee_proclet;
   capacity = std::max(kMinProcletHeapSize, round_up_to_power2(capacity));
   BUG_ON(capacity > kMaxProcletHeapSize);
@@ -206,12 +209,20 @@ Proclet<T> Proclet<T>::__create(bool pinned, uint64_t capacity, NodeIP ip_hint,
   {
     RuntimeSlabGuard slab_guard;
 
-    auto optional =
-        get_runtime()->controller_client()->allocate_proclet(capacity, ip_hint);
+    std::optional<ProcletAllocation> optional;
+    if (ip_hint == get_cfg_ip()) {
+      optional = get_runtime()->proclet_manager()->acquire_warm_heap(capacity);
+    }
+    if (!optional) {
+      optional = get_runtime()->controller_client()->allocate_proclet(
+          capacity, ip_hint);
+    }
     if (unlikely(!optional)) {
       throw OutOfMemory();
     }
-    std::tie(callee_id, server_ip) = *optional;
+    callee_id = optional->id;
+    server_ip = optional->ip;
+    generation = optional->generation;
     get_runtime()->rpc_client_mgr()->update_cache(callee_id, server_ip);
     callee_proclet.id_ = callee_id;
 
@@ -230,7 +241,7 @@ Proclet<T> Proclet<T>::__create(bool pinned, uint64_t capacity, NodeIP ip_hint,
     // Fast path: the proclet is actually local, use normal function call.
     ProcletServer::construct_proclet_locally<T, As...>(
         std::move(*optional_caller_migration_guard), to_proclet_base(callee_id),
-        capacity, pinned, std::forward<As>(args)...);
+        capacity, pinned, generation, std::forward<As>(args)...);
     return callee_proclet;
   }
 
@@ -244,7 +255,7 @@ Proclet<T> Proclet<T>::__create(bool pinned, uint64_t capacity, NodeIP ip_hint,
 #endif
 
   invoke_remote(std::move(*optional_caller_migration_guard), callee_id, handler,
-                to_proclet_base(callee_id), capacity, pinned,
+                to_proclet_base(callee_id), capacity, pinned, generation,
 #ifdef DDB_SUPPORT
                 meta,
 #endif
@@ -252,6 +263,106 @@ Proclet<T> Proclet<T>::__create(bool pinned, uint64_t capacity, NodeIP ip_hint,
   return callee_proclet;
 }
 
+template <typename T>
+template <typename... As>
+std::vector<Proclet<T>> Proclet<T>::__create_batch(uint32_t num, bool pinned,
+                                                   uint64_t capacity,
+                                                   NodeIP ip_hint,
+                                                   As &...args) {
+  std::vector<ProcletAllocation> allocated;
+  capacity = std::max(kMinProcletHeapSize, round_up_to_power2(capacity));
+  BUG_ON(capacity > kMaxProcletHeapSize);
+
+  ProcletHeader *caller_header;
+  {
+    MigrationGuard caller_migration_guard;
+
+    caller_header = caller_migration_guard.header();
+    get_runtime()->detach();
+  }
+
+  std::optional<MigrationGuard> optional_caller_migration_guard;
+  {
+    RuntimeSlabGuard slab_guard;
+
+    allocated = get_runtime()->controller_client()->allocate_proclets(
+        capacity, ip_hint, num);
+    if (unlikely(allocated.size() != num)) {
+      throw OutOfMemory();
+    }
+    for (auto &[id, ip, _] : allocated) {
+      get_runtime()->rpc_client_mgr()->update_cache(id, ip);
+    }
+
+    optional_caller_migration_guard =
+        get_runtime()->attach_and_disable_migration(caller_header);
+    if (!optional_caller_migration_guard) {
+      RPCReturnBuffer return_buf;
+      *optional_caller_migration_guard =
+          Migrator::migrate_thread_and_ret_val<void>(
+              std::move(return_buf), to_proclet_id(caller_header), nullptr,
+              nullptr);
+    }
+  }
+
+#ifdef DDB_SUPPORT
+  DDB::DDBTraceMeta meta;
+  DDB::get_trace_meta(&meta);
+  embed_proclet_id(meta, to_proclet_id(caller_header));
+#endif
+  optional_caller_migration_guard.reset();
+
+  std::vector<Proclet<T>> proclets(num);
+  std::map<NodeIP, std::pair<std::vector<ProcletID>, std::vector<uint32_t>>>
+      node_to_ids;
+  for (uint32_t i = 0; i < num; i++) {
+    auto [id, ip, generation] = allocated[i];
+    proclets[i].id_ = id;
+    node_to_ids[ip].first.push_back(id);
+    node_to_ids[ip].second.push_back(generation);
+  }
+
+  // One batched construction RPC per destination node; the proclets placed on
+  // the caller's node are constructed through function calls instead.
+  auto construct = [&](NodeIP ip, const std::vector<ProcletID> &ids,
+                       const std::vector<uint32_t> &generations) {
+    auto *handler = ProcletServer::construct_proclets<T, std::decay_t<As>...>;
+
+    for (uint32_t i = 0; i < ids.size(); i++) {
+      MigrationGuard caller_migration_guard;
+
+      if (ip != get_cfg_ip()) {
+        std::vector<ProcletID> remaining_ids(ids.begin() + i, ids.end());
+        std::vector<uint32_t> remaining_generations(generations.begin() + i,
+                                                    generations.end());
+        invoke_remote(std::move(caller_migration_guard), remaining_ids.front(),
+                      handler, remaining_ids, remaining_generations, capacity,
+                      pinned,
+#ifdef DDB_SUPPORT
+                      meta,
+#endif
+                      args...);
+        break;
+      }
+      ProcletServer::construct_proclet_locally<T, As &...>(
+          std::move(caller_migration_guard), to_proclet_base(ids[i]), capacity,
+          pinned, generations[i], args...);
+    }
+  };
+
+  std::vector<Future<void>> futures;
+  for (auto &[ip, ids_and_generations] : node_to_ids) {
+    futures.emplace_back(nu::async(
+        [&, ip = ip, &ids_and_generations = ids_and_generations] {
+          construct(ip, ids_and_generations.first,
+                    ids_and_generations.second);
+        }));
+  }
+  futures.clear();
+
+  return proclets;
+}
+
 template <typename T>
 inline Proclet<T>::operator bool() const {
   return id_;
@@ -268,8 +379,8 @@ inline ProcletID Proclet<T>::get_id() const {
 }
 
 template <typename T>
-template <bool MigrEn, bool CPUMon, bool CPUSamp, typename RetT,
-          typename... S0s, typename... S1s>
+template <bool MigrEn, bool CPUMon, bool CPUSamp, RPCPriority Prio,
+          typename RetT, typename... S0s, typename... S1s>
 inline Future<RetT> Proclet<T>::run_async(RetT (*fn)(T &, S0s...),
                                           S1s &&...states)
   requires ValidInvocationTypes<RetT, S0s...>
@@ -277,34 +388,34 @@ inline Future<RetT> Proclet<T>::run_async(RetT (*fn)(T &, S0s...),
   using fn_states_checker [[maybe_unused]] =
       decltype(fn(std::declval<T &>(), std::forward<S1s>(states)...));
 
-  return __run_async<MigrEn, CPUMon, CPUSamp>(fn, std::forward<S1s>(states)...);
+  return __run_async<MigrEn, CPUMon, CPUSamp, Prio>(fn, std::forward<S1s>(states)...);
 }
 
 template <typename T>
-template <bool MigrEn, bool CPUMon, bool CPUSamp, typename RetT,
-          typename... S0s, typename... S1s>
+template <bool MigrEn, bool CPUMon, bool CPUSamp, RPCPriority Prio,
+          typename RetT, typename... S0s, typename... S1s>
 inline Future<RetT> Proclet<T>::__run_async(RetT (*fn)(T &, S0s...),
                                             S1s &&...states) {
   return nu::async([&, fn, ... states = std::forward<S1s>(states)]() mutable {
-    return __run<MigrEn, CPUMon, CPUSamp>(fn, std::forward<S1s>(states)...);
+    return __run<MigrEn, CPUMon, CPUSamp, Prio>(fn, std::forward<S1s>(states)...);
   });
 }
 
 template <typename T>
-template <bool MigrEn, bool CPUMon, bool CPUSamp, typename RetT,
-          typename... S0s, typename... S1s>
+template <bool MigrEn, bool CPUMon, bool CPUSamp, RPCPriority Prio,
+          typename RetT, typename... S0s, typename... S1s>
 inline RetT Proclet<T>::run(RetT (*fn)(T &, S0s...), S1s &&...states)
   requires ValidInvocationTypes<RetT, S0s...>
 {
   using fn_states_checker [[maybe_unused]] =
       decltype(fn(std::declval<T &>(), std::move(states)...));
 
-  return __run<MigrEn, CPUMon, CPUSamp>(fn, std::forward<S1s>(states)...);
+  return __run<MigrEn, CPUMon, CPUSamp, Prio>(fn, std::forward<S1s>(states)...);
 }
 
 template <typename T>
-template <bool MigrEn, bool CPUMon, bool CPUSamp, typename RetT,
-          typename... S0s, typename... S1s>
+template <bool MigrEn, bool CPUMon, bool CPUSamp, RPCPriority Prio,
+          typename RetT, typename... S0s, typename... S1s>
 RetT Proclet<T>::__run(RetT (*fn)(T &, S0s...), S1s &&...states) {
   MigrationGuard caller_migration_guard;
 
@@ -315,6 +426,10 @@ RetT Proclet<T>::__run(RetT (*fn)(T &, S0s...), S1s &&...states) {
                                                     caller_migration_guard);
   if (optional_callee_migration_guard) {
     // Fast path: the callee proclet is actually local, use function call.
+    if constexpr (Prio == kHighPriority) {
+      callee_header->num_high_priority_calls.fetch_add(
+          1, std::memory_order_relaxed);
+    }
 
     constexpr auto kHasRetVal = !std::is_same_v<RetT, void>;
     std::conditional_t<kHasRetVal, RetT, ErasedType> ret;
@@ -360,62 +475,63 @@ RetT Proclet<T>::__run(RetT (*fn)(T &, S0s...), S1s &&...states) {
 #endif
 
   if constexpr (!std::is_same<RetT, void>::value) {
-    return invoke_remote_with_ret<RetT>(std::move(caller_migration_guard), id_,
-                                        handler, id_, fn,
+    return invoke_remote_with_ret<RetT, Prio>(
+        std::move(caller_migration_guard), id_, handler, id_, fn,
 #ifdef DDB_SUPPORT
-                                        meta,
+        meta,
 #endif
-                                        std::forward<S1s>(states)...);
+        std::forward<S1s>(states)...);
   } else {
-    invoke_remote(std::move(caller_migration_guard), id_, handler, id_, fn,
+    invoke_remote<Prio>(std::move(caller_migration_guard), id_, handler, id_,
+                        fn,
 #ifdef DDB_SUPPORT
-                  meta,
+                        meta,
 #endif
-                  std::forward<S1s>(states)...);
+                        std::forward<S1s>(states)...);
   }
 }
 
 template <typename T>
-template <bool MigrEn, bool CPUMon, bool CPUSamp, typename RetT,
-          typename... A0s, typename... A1s>
+template <bool MigrEn, bool CPUMon, bool CPUSamp, RPCPriority Prio,
+          typename RetT, typename... A0s, typename... A1s>
 inline Future<RetT> Proclet<T>::run_async(RetT (T::*md)(A0s...), A1s &&...args)
   requires ValidInvocationTypes<RetT, A0s...>
 {
   using md_args_checker [[maybe_unused]] =
       decltype((std::declval<T>().*(md))(std::move(args)...));
 
-  return __run_async<MigrEn, CPUMon, CPUSamp>(md, std::forward<A1s>(args)...);
+  return __run_async<MigrEn, CPUMon, CPUSamp, Prio>(md, std::forward<A1s>(args)...);
 }
 
 template <typename T>
-template <bool MigrEn, bool CPUMon, bool CPUSamp, typename RetT,
-          typename... A0s, typename... A1s>
+template <bool MigrEn, bool CPUMon, bool CPUSamp, RPCPriority Prio,
+          typename RetT, typename... A0s, typename... A1s>
 inline Future<RetT> Proclet<T>::__run_async(RetT (T::*md)(A0s...),
                                             A1s &&...args) {
   return nu::async([&, md, ... args = std::forward<A1s>(args)]() mutable {
-    return __run<MigrEn, CPUMon, CPUSamp>(md, std::forward<A1s>(args)...);
+    return __run<MigrEn, CPUMon, CPUSamp, Prio>(md, std::forward<A1s>(args)...);
   });
 }
 
 template <typename T>
-template <bool MigrEn, bool CPUMon, bool CPUSamp, typename RetT,
-          typename... A0s, typename... A1s>
+template <bool MigrEn, bool CPUMon, bool CPUSamp, RPCPriority Prio,
+          typename RetT, typename... A0s, typename... A1s>
 inline RetT Proclet<T>::run(RetT (T::*md)(A0s...), A1s &&...args)
   requires ValidInvocationTypes<RetT, A0s...>
 {
   using md_args_checker [[maybe_unused]] =
       decltype((std::declval<T>().*(md))(std::forward<A1s>(args)...));
 
-  return __run<MigrEn, CPUMon, CPUSamp>(md, std::forward<A1s>(args)...);
+  return __run<MigrEn, CPUMon, CPUSamp, Prio>(md, std::forward<A1s>(args)...);
 }
 
 template <typename T>
-template <bool MigrEn, bool CPUMon, bool CPUSamp, typename RetT,
-          typename... A0s, typename... A1s>
+template <bool MigrEn, bool CPUMon, bool CPUSamp, RPCPriority Prio,
+          typename RetT, typename... A0s, typename... A1s>
 inline RetT Proclet<T>::__run(RetT (T::*md)(A0s...), A1s &&...args) {
   MethodPtr<decltype(md)> method_ptr;
   method_ptr.ptr = md;
-  return __run<MigrEn, CPUMon, CPUSamp>(
+  return __run<MigrEn, CPUMon, CPUSamp, Prio>(
       +[](T &t, decltype(method_ptr) method_ptr, A0s... args) {
         return (t.*(method_ptr.ptr))(std::move(args)...);
       },
@@ -512,6 +628,44 @@ inline bool Proclet<T>::is_local() const {
   return to_proclet_header(id_)->is_local();
 }
 
+template <typename T>
+void Proclet<T>::enable_invocation_stats() {
+  run(+[](T &) {
+    auto *header = get_runtime()->get_current_proclet_header();
+    if (header->invocation_stats.load(std::memory_order_acquire)) {
+      return;
+    }
+    // Allocated on the proclet heap so that it migrates with the proclet.
+    auto *stats = new InvocationStats();
+    InvocationStats *expected = nullptr;
+    if (!header->invocation_stats.compare_exchange_strong(
+            expected, stats, std::memory_order_acq_rel)) {
+      delete stats;
+    }
+  });
+}
+
+template <typename T>
+std::vector<InvocationStats::MethodStats> Proclet<T>::get_invocation_stats() {
+  return run(+[](T &) {
+    auto *header = get_runtime()->get_current_proclet_header();
+    auto *stats = header->invocation_stats.load(std::memory_order_acquire);
+    return stats ? stats->get_all()
+                 : std::vector<InvocationStats::MethodStats>();
+  });
+}
+
+template <typename T>
+void Proclet<T>::reset_invocation_stats() {
+  run(+[](T &) {
+    auto *header = get_runtime()->get_current_proclet_header();
+    auto *stats = header->invocation_stats.load(std::memory_order_acquire);
+    if (stats) {
+      stats->reset();
+    }
+  });
+}
+
 template <typename T>
 inline WeakProclet<T>::WeakProclet() {}
 
@@ -598,4 +752,52 @@ inline Future<Proclet<T>> make_proclet_async(bool pinned,
   return nu::async([=] { return make_proclet<T>(pinned, capacity, ip_hint); });
 }
 
+template <typename T, typename... As>
+inline std::vector<Proclet<T>> make_proclets(uint32_t num,
+                                             std::tuple<As...> args_tuple,
+                                             bool pinned,
+                                             std::optional<uint64_t> capacity,
+                                             std::optional<NodeIP> ip_hint) {
+  return std::apply(
+      [&](auto &...args) {
+        return Proclet<T>::__create_batch(
+            num, pinned, capacity.value_or(kDefaultProcletHeapSize),
+            ip_hint.value_or(0), args...);
+      },
+      args_tuple);
+}
+
+template <typename T, typename... As>
+inline Future<std::vector<Proclet<T>>> make_proclets_async(
+    uint32_t num, std::tuple<As...> args_tuple, bool pinned,
+    std::optional<uint64_t> capacity, std::optional<NodeIP> ip_hint) {
+  return nu::async([=] {
+    return make_proclets<T>(num, args_tuple, pinned, capacity, ip_hint);
+  });
+}
+
+template <typename T>
+inline std::vector<Proclet<T>> make_proclets(uint32_t num, bool pinned,
+                                             std::optional<uint64_t> capacity,
+                                             std::optional<NodeIP> ip_hint) {
+  return Proclet<T>::__create_batch(num, pinned,
+                                    capacity.value_or(kDefaultProcletHeapSize),
+                                    ip_hint.value_or(0));
+}
+
+template <typename T>
+inline Future<std::vector<Proclet<T>>> make_proclets_async(
+    uint32_t num, bool pinned, std::optional<uint64_t> capacity,
+    std::optional<NodeIP> ip_hint) {
+  return nu::async(
+      [=] { return make_proclets<T>(num, pinned, capacity, ip_hint); });
+}
+
+template <typename T>
+inline Proclet<T> restore_proclet(ProcletID id) {
+  Proclet<T> proclet;
+  proclet.id_ = id;
+  return proclet;
+}
+
 }  // namespace nu
@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <spanstream>
+#include <sstream>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "nu/cereal.hpp"
+
+namespace nu {
+
+template <typename T>
+inline ProcletCombiner<T>::ProcletCombiner(WeakProclet<T> proclet)
+    : proclet_(std::move(proclet)), in_flight_(false) {}
+
+template <typename T>
+template <typename RetT, typename... S0s>
+std::string ProcletCombiner<T>::invoke(T &t, const std::string &args) {
+  using Fn = RetT (*)(T &, S0s...);
+
+  std::ispanstream iss(std::span<const char>(args.data(), args.size()));
+  cereal::BinaryInputArchive ia(iss);
+  uintptr_t fn_addr;
+  ia >> fn_addr;
+  std::tuple<std::decay_t<S0s>...> states;
+  std::apply([&](auto &...states) { ((ia >> states), ...); }, states);
+
+  auto call_fn = [&] {
+    return std::apply(
+        [&](auto &...states) {
+          return reinterpret_cast<Fn>(fn_addr)(t, std::move(states)...);
+        },
+        states);
+  };
+
+  if constexpr (std::is_void_v<RetT>) {
+    call_fn();
+    return std::string();
+  } else {
+    std::ostringstream oss;
+    {
+      cereal::BinaryOutputArchive oa(oss);
+      oa << call_fn();
+    }
+    return std::move(oss).str();
+  }
+}
+
+template <typename T>
+void ProcletCombiner<T>::combine(Call *call) {
+  mutex_.lock();
+  pending_.push_back(call);
+
+  while (!call->done) {
+    if (in_flight_) {
+      cond_var_.wait(&mutex_);
+      continue;
+    }
+
+    // Become the combiner of whatever has been queued so far.
+    in_flight_ = true;
+    auto batch_size = std::min<std::size_t>(pending_.size(), kMaxBatchSize);
+    std::vector<Call *> batch(pending_.begin(), pending_.begin() + batch_size);
+    pending_.erase(pending_.begin(), pending_.begin() + batch_size);
+    mutex_.unlock();
+
+    std::vector<std::pair<uintptr_t, std::string>> reqs;
+    reqs.reserve(batch.size());
+    for (auto *c : batch) {
+      reqs.emplace_back(c->invoker_addr, std::move(c->args));
+    }
+    auto rets = proclet_.run(
+        +[](T &t, std::vector<std::pair<uintptr_t, std::string>> reqs) {
+          std::vector<std::string> rets;
+          rets.reserve(reqs.size());
+          for (auto &[invoker_addr, args] : reqs) {
+            rets.emplace_back(reinterpret_cast<Invoker>(invoker_addr)(t, args));
+          }
+          return rets;
+        },
+        std::move(reqs));
+
+    mutex_.lock();
+    for (std::size_t i = 0; i < batch.size(); i++) {
+      batch[i]->ret = std::move(rets[i]);
+      batch[i]->done = true;
+    }
+    in_flight_ = false;
+    cond_var_.signal_all();
+  }
+
+  mutex_.unlock();
+}
+
+template <typename T>
+template <typename RetT, typename... S0s, typename... S1s>
+inline Future<RetT> ProcletCombiner<T>::run_async(RetT (*fn)(T &, S0s...),
+                                                  S1s &&...states)
+  requires ValidInvocationTypes<RetT, S0s...>
+{
+  using fn_states_checker [[maybe_unused]] =
+      decltype(fn(std::declval<T &>(), std::forward<S1s>(states)...));
+
+  return nu::async([&, fn, ... states = std::forward<S1s>(states)]() mutable {
+    return run(fn, std::move(states)...);
+  });
+}
+
+template <typename T>
+template <typename RetT, typename... S0s, typename... S1s>
+RetT ProcletCombiner<T>::run(RetT (*fn)(T &, S0s...), S1s &&...states)
+  requires ValidInvocationTypes<RetT, S0s...>
+{
+  using fn_states_checker [[maybe_unused]] =
+      decltype(fn(std::declval<T &>(), std::move(states)...));
+
+  Call call;
+  call.invoker_addr = reinterpret_cast<uintptr_t>(invoke<RetT, S0s...>);
+  {
+    std::ostringstream oss;
+    {
+      cereal::BinaryOutputArchive oa(oss);
+      oa << reinterpret_cast<uintptr_t>(fn);
+      ((oa << std::decay_t<S0s>(std::forward<S1s>(states))), ...);
+    }
+    call.args = std::move(oss).str();
+  }
+
+  combine(&call);
+
+  if constexpr (!std::is_void_v<RetT>) {
+    std::ispanstream iss(
+        std::span<const char>(call.ret.data(), call.ret.size()));
+    cereal::BinaryInputArchive ia(iss);
+    RetT ret;
+    ia >> ret;
+    return ret;
+  }
+}
+
+template <typename T>
+template <typename RetT, typename... A0s, typename... A1s>
+Future<RetT> ProcletCombiner<T>::run_async(RetT (T::*md)(A0s...),
+                                           A1s &&...args)
+  requires ValidInvocationTypes<RetT, A0s...>
+{
+  using md_args_checker [[maybe_unused]] =
+      decltype((std::declval<T>().*(md))(std::forward<A1s>(args)...));
+
+  MethodPtr<decltype(md)> method_ptr;
+  method_ptr.ptr = md;
+  return run_async(
+      +[](T &t, decltype(method_ptr) method_ptr, A0s... args) {
+        return (t.*(method_ptr.ptr))(std::move(args)...);
+      },
+      method_ptr, std::forward<A1s>(args)...);
+}
+
+template <typename T>
+template <typename RetT, typename... A0s, typename... A1s>
+RetT ProcletCombiner<T>::run(RetT (T::*md)(A0s...), A1s &&...args)
+  requires ValidInvocationTypes<RetT, A0s...>
+{
+  using md_args_checker [[maybe_unused]] =
+      decltype((std::declval<T>().*(md))(std::forward<A1s>(args)...));
+
+  MethodPtr<decltype(md)> method_ptr;
+  method_ptr.ptr = md;
+  return run(
+      +[](T &t, decltype(method_ptr) method_ptr, A0s... args) {
+        return (t.*(method_ptr.ptr))(std::move(args)...);
+      },
+      method_ptr, std::forward<A1s>(args)...);
+}
+
+}  // namespace nu
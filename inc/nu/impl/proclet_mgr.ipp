@@ -38,6 +38,10 @@ inline SpinLock &ProcletHeader::migration_spin() {
   return proclet_migration_spin[global_idx()];
 }
 
+inline ProcletLocation &ProcletHeader::forward_location() {
+  return proclet_forward_locations[global_idx()];
+}
+
 inline VAddrRange ProcletHeader::range() const {
   auto start_addr = reinterpret_cast<uint64_t>(this);
   auto end_addr = start_addr + capacity;
@@ -52,6 +56,22 @@ inline void ProcletManager::wait_until_being_local(
   }
 }
 
+inline void ProcletManager::wait_until_handed_off(
+    ProcletHeader *proclet_header) {
+  if (likely(load_acquire(&proclet_header->status()) != kMigrating)) {
+    return;
+  }
+
+  // The forward location catches up with the location epoch once the state
+  // is at the destination.
+  ScopedLock lock(&proclet_header->spin_lock);
+  while (Caladan::access_once(proclet_header->status()) == kMigrating &&
+         Caladan::access_once(proclet_header->forward_location().epoch) !=
+             Caladan::access_once(proclet_header->location_epoch)) {
+    proclet_header->cond_var.wait(&proclet_header->spin_lock);
+  }
+}
+
 inline void ProcletManager::insert(void *proclet_base) {
   ScopedLock lock(&spin_);
   reinterpret_cast<ProcletHeader *>(proclet_base)->status() = kPresent;
@@ -87,6 +107,27 @@ inline bool ProcletManager::remove_for_destruction(void *proclet_base) {
   return __remove(proclet_base, kDestructing);
 }
 
+inline void ProcletManager::restore_spilled(void *proclet_base) {
+  auto *proclet_header = reinterpret_cast<ProcletHeader *>(proclet_base);
+
+  {
+    ScopedLock lock(&spin_);
+    proclet_header->status() = kPresent;
+    num_present_proclets_++;
+    present_proclets_.push_back(proclet_base);
+  }
+  {
+    ScopedLock lock(&proclet_header->spin_lock);
+    proclet_header->cond_var.signal_all();
+  }
+}
+
+inline bool ProcletManager::can_spill() const { return !spill_dir_.empty(); }
+
+inline const std::vector<ProcletID> &ProcletManager::get_restored_ids() const {
+  return restored_ids_;
+}
+
 inline bool ProcletManager::__remove(void *proclet_base,
                                      ProcletStatus new_status) {
   auto *proclet_header = reinterpret_cast<ProcletHeader *>(proclet_base);
@@ -6,9 +6,11 @@
 #include <syncstream>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "nu/ctrl.hpp"
 #include "nu/ctrl_client.hpp"
+#include "nu/invocation_stats.hpp"
 #include "nu/migrator.hpp"
 #include "nu/proclet_mgr.hpp"
 #include "nu/runtime.hpp"
@@ -26,6 +28,15 @@ template <typename Cls, typename... As>
 void ProcletServer::__construct_proclet(MigrationGuard *callee_guard, Cls *obj,
                                         ArchivePool<>::IASStream *ia_sstream,
                                         RPCReturner returner) {
+  __construct_root_obj<Cls, As...>(callee_guard, obj, ia_sstream);
+
+  auto *oa_sstream = get_runtime()->archive_pool()->get_oa_sstream();
+  get_runtime()->send_rpc_resp_ok(oa_sstream, ia_sstream, &returner);
+}
+
+template <typename Cls, typename... As>
+void ProcletServer::__construct_root_obj(MigrationGuard *callee_guard, Cls *obj,
+                                         ArchivePool<>::IASStream *ia_sstream) {
   auto *callee_header = callee_guard->header();
   auto &callee_slab = callee_header->slab;
   callee_header->root_obj = callee_slab.yield(sizeof(Cls));
@@ -74,9 +85,6 @@ void ProcletServer::__construct_proclet(MigrationGuard *callee_guard, Cls *obj,
       std::destroy_at(args);
     });
   }
-
-  auto *oa_sstream = get_runtime()->archive_pool()->get_oa_sstream();
-  get_runtime()->send_rpc_resp_ok(oa_sstream, ia_sstream, &returner);
 }
 
 template <typename Cls, typename... As>
@@ -85,11 +93,13 @@ void ProcletServer::construct_proclet(ArchivePool<>::IASStream *ia_sstream,
   void *base;
   uint64_t size;
   bool pinned;
-  ia_sstream->ia >> base >> size >> pinned;
+  uint32_t generation;
+  ia_sstream->ia >> base >> size >> pinned >> generation;
 
   get_runtime()->proclet_manager()->setup(base, size,
                                           /* migratable = */ !pinned,
-                                          /* from_migration = */ false);
+                                          /* from_migration = */ false,
+                                          generation);
 
   auto *proclet_header = reinterpret_cast<ProcletHeader *>(base);
   proclet_header->status() = kPresent;
@@ -101,15 +111,50 @@ void ProcletServer::construct_proclet(ArchivePool<>::IASStream *ia_sstream,
   get_runtime()->proclet_manager()->insert(base);
 }
 
+template <typename Cls, typename... As>
+void ProcletServer::construct_proclets(ArchivePool<>::IASStream *ia_sstream,
+                                       RPCReturner *returner) {
+  std::vector<ProcletID> ids;
+  std::vector<uint32_t> generations;
+  uint64_t size;
+  bool pinned;
+  ia_sstream->ia >> ids >> generations >> size >> pinned;
+
+  // All proclets of the batch are constructed from the same args.
+  auto args_pos = ia_sstream->ss.tellg();
+  for (uint32_t i = 0; i < ids.size(); i++) {
+    ia_sstream->ss.seekg(args_pos);
+
+    auto *base = to_proclet_base(ids[i]);
+    get_runtime()->proclet_manager()->setup(base, size,
+                                            /* migratable = */ !pinned,
+                                            /* from_migration = */ false,
+                                            generations[i]);
+
+    auto *proclet_header = reinterpret_cast<ProcletHeader *>(base);
+    proclet_header->status() = kPresent;
+
+    bool proclet_not_found = !get_runtime()->run_within_proclet_env<Cls>(
+        base, __construct_root_obj<Cls, As...>, ia_sstream);
+    BUG_ON(proclet_not_found);
+
+    get_runtime()->proclet_manager()->insert(base);
+  }
+
+  returner->Return(kOk);
+}
+
 template <typename Cls, typename... As>
 void ProcletServer::construct_proclet_locally(MigrationGuard &&caller_guard,
                                               void *base, uint64_t size,
-                                              bool pinned, As &&...args) {
+                                              bool pinned, uint32_t generation,
+                                              As &&...args) {
   std::optional<MigrationGuard> optional_caller_guard;
   RuntimeSlabGuard slab_guard;
   get_runtime()->proclet_manager()->setup(base, size,
                                           /* migratable = */ !pinned,
-                                          /* from_migration = */ false);
+                                          /* from_migration = */ false,
+                                          generation);
 
   auto *callee_header = reinterpret_cast<ProcletHeader *>(base);
   callee_header->status() = kPresent;
@@ -237,14 +282,11 @@ void ProcletServer::update_ref_cnt(ArchivePool<>::IASStream *ia_sstream,
   if (destructed) {
     // Wait for other concurrent cnt updating threads to finish.
     proclet_header->rcu_lock.writer_sync();
-    get_runtime()->proclet_manager()->cleanup(proclet_base,
-                                              /* for_migration = */ false);
-    get_runtime()->controller_client()->destroy_proclet(
-        proclet_header->range());
+    get_runtime()->proclet_manager()->destroy(proclet_base);
   }
 
   if (proclet_not_found) {
-    get_runtime()->send_rpc_resp_wrong_client(returner);
+    get_runtime()->send_rpc_resp_wrong_client(id, returner);
   }
 }
 
@@ -286,9 +328,7 @@ void ProcletServer::update_ref_cnt_locally(MigrationGuard *callee_guard,
         callee_header->rcu_lock.writer_sync();
       });
     }
-    get_runtime()->proclet_manager()->cleanup(callee_header,
-                                              /* for_migration = */ false);
-    get_runtime()->controller_client()->destroy_proclet(callee_header->range());
+    get_runtime()->proclet_manager()->destroy(callee_header);
   }
 
   optional_caller_guard = get_runtime()->reattach_and_disable_migration(
@@ -312,6 +352,17 @@ void ProcletServer::__run_closure(MigrationGuard *callee_guard, Cls *obj,
                                   ArchivePool<>::IASStream *ia_sstream,
                                   RPCReturner returner) {
   auto *callee_header = callee_guard->header();
+  auto *invocation_stats =
+      callee_header->invocation_stats.load(std::memory_order_relaxed);
+  uint64_t start_tsc = 0;
+  if (unlikely(invocation_stats)) {
+    start_tsc = rdtsc();
+  }
+  callee_header->callers.record(returner.remote_addr.ip);
+  if (returner.priority == kHighPriority) {
+    callee_header->num_high_priority_calls.fetch_add(1,
+                                                     std::memory_order_relaxed);
+  }
   ProcletSlabGuard callee_slab_guard(&callee_header->slab);
 
   if constexpr (CPUMon) {
@@ -337,7 +388,15 @@ void ProcletServer::__run_closure(MigrationGuard *callee_guard, Cls *obj,
   std::tuple<std::decay_t<S1s>...> states;
   std::apply([&](auto &&...states) { ((ia_sstream->ia >> states), ...); },
              states);
-  
+
+  InvocationStats::Entry *stats_entry = nullptr;
+  uint64_t exec_start_tsc = 0;
+  if (unlikely(invocation_stats)) {
+    stats_entry = invocation_stats->get_entry(
+        InvocationStats::to_method_key(fn, states));
+    exec_start_tsc = rdtsc();
+  }
+
   auto __apply_fn = [&] {
     std::apply(
         [&](auto &&...states) {
@@ -377,12 +436,28 @@ void ProcletServer::__run_closure(MigrationGuard *callee_guard, Cls *obj,
     apply_fn();
   }
 
+  uint64_t exec_end_tsc = 0;
+  if (unlikely(stats_entry)) {
+    exec_end_tsc = rdtsc();
+  }
+
   RuntimeSlabGuard runtime_slab_guard;
 
   auto *oa_sstream = get_runtime()->archive_pool()->get_oa_sstream();
   if constexpr (kNonVoidRetT) {
     oa_sstream->oa << std::move(ret);
   }
+
+  if (unlikely(stats_entry)) {
+    auto end_tsc = rdtsc();
+    if (returner.recv_tsc) {
+      stats_entry->queueing.add(start_tsc - returner.recv_tsc);
+    }
+    stats_entry->execution.add(exec_end_tsc - exec_start_tsc);
+    stats_entry->serialization.add((exec_start_tsc - start_tsc) +
+                                   (end_tsc - exec_end_tsc));
+  }
+
   get_runtime()->send_rpc_resp_ok(oa_sstream, ia_sstream, &returner);
 
   if constexpr (CPUMon) {
@@ -407,7 +482,7 @@ void ProcletServer::run_closure(ArchivePool<>::IASStream *ia_sstream,
       ia_sstream, *returner);
 
   if (proclet_not_found) {
-    get_runtime()->send_rpc_resp_wrong_client(returner);
+    get_runtime()->send_rpc_resp_wrong_client(id, returner);
   }
 }
 
@@ -431,6 +506,16 @@ void ProcletServer::run_closure_locally(
 
   auto *obj = get_runtime()->get_root_obj<Cls>(to_proclet_id(callee_header));
 
+  auto *invocation_stats =
+      callee_header->invocation_stats.load(std::memory_order_relaxed);
+  InvocationStats::Entry *stats_entry = nullptr;
+  uint64_t start_tsc = 0;
+  if (unlikely(invocation_stats)) {
+    stats_entry = invocation_stats->get_entry(
+        InvocationStats::to_method_key(fn_ptr, *states));
+    start_tsc = rdtsc();
+  }
+
   if constexpr (!std::is_same<RetT, void>::value) {
     auto *ret = reinterpret_cast<RetT *>(alloca(sizeof(RetT)));
     std::apply(
@@ -447,6 +532,11 @@ void ProcletServer::run_closure_locally(
     if constexpr (CPUMon) {
       callee_header->cpu_load.end_monitor();
     }
+    uint64_t exec_end_tsc = 0;
+    if (unlikely(stats_entry)) {
+      exec_end_tsc = rdtsc();
+      stats_entry->execution.add(exec_end_tsc - start_tsc);
+    }
 
     auto optional_caller_guard = get_runtime()->reattach_and_disable_migration(
         caller_header, *callee_migration_guard);
@@ -454,6 +544,9 @@ void ProcletServer::run_closure_locally(
       ProcletSlabGuard slab_guard(&caller_header->slab);
       *caller_ptr = pass_across_proclet(std::move(*ret));
       std::destroy_at(ret);
+      if (unlikely(stats_entry)) {
+        stats_entry->serialization.add(rdtsc() - exec_end_tsc);
+      }
       callee_migration_guard->reset();
       *caller_migration_guard = std::move(*optional_caller_guard);
       return;
@@ -470,6 +563,9 @@ void ProcletServer::run_closure_locally(
     RPCReturnBuffer ret_val_buf(ret_val_span);
 
     std::destroy_at(ret);
+    if (unlikely(stats_entry)) {
+      stats_entry->serialization.add(rdtsc() - exec_end_tsc);
+    }
     callee_migration_guard->reset();
 
     *caller_migration_guard = Migrator::migrate_thread_and_ret_val<RetT>(
@@ -491,6 +587,9 @@ void ProcletServer::run_closure_locally(
     if constexpr (CPUMon) {
       callee_header->cpu_load.end_monitor();
     }
+    if (unlikely(stats_entry)) {
+      stats_entry->execution.add(rdtsc() - start_tsc);
+    }
 
     auto optional_caller_guard = get_runtime()->reattach_and_disable_migration(
         caller_header, *callee_migration_guard);
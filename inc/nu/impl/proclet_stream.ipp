@@ -0,0 +1,169 @@
+#include <experimental/scope>
+#include <type_traits>
+#include <utility>
+
+#include "nu/utils/scoped_lock.hpp"
+#include "nu/utils/thread.hpp"
+
+namespace nu {
+
+template <typename T>
+inline void ProcletStream<T>::State::wait_for_turn(uint64_t seq) {
+  ScopedLock<Mutex> lock(&mutex);
+  if (next_seq == seq) {
+    return;
+  }
+
+  CondVar cond_var;
+  waiters.emplace(seq, &cond_var);
+  while (next_seq != seq) {
+    cond_var.wait(&mutex);
+  }
+  waiters.erase(seq);
+}
+
+template <typename T>
+inline void ProcletStream<T>::State::finish_turn() {
+  ScopedLock<Mutex> lock(&mutex);
+  auto iter = waiters.find(++next_seq);
+  if (iter != waiters.end()) {
+    iter->second->signal();
+  }
+}
+
+template <typename T>
+inline ProcletStream<T>::ProcletStream() : state_addr_(0), next_seq_(0) {}
+
+template <typename T>
+ProcletStream<T>::ProcletStream(WeakProclet<T> proclet)
+    : proclet_(std::move(proclet)), next_seq_(0) {
+  // Allocated from the slab of the target proclet.
+  state_addr_ = proclet_.run(
+      +[](T &) { return reinterpret_cast<uintptr_t>(new State()); });
+}
+
+template <typename T>
+inline ProcletStream<T>::ProcletStream(ProcletStream &&o)
+    : proclet_(std::move(o.proclet_)),
+      state_addr_(std::exchange(o.state_addr_, 0)),
+      next_seq_(o.next_seq_) {}
+
+template <typename T>
+inline ProcletStream<T> &ProcletStream<T>::operator=(ProcletStream &&o) {
+  if (state_addr_) {
+    Thread([future = release_async()]() mutable { future.get(); }).detach();
+  }
+  proclet_ = std::move(o.proclet_);
+  state_addr_ = std::exchange(o.state_addr_, 0);
+  next_seq_ = o.next_seq_;
+  return *this;
+}
+
+template <typename T>
+inline ProcletStream<T>::~ProcletStream() {
+  if (state_addr_) {
+    Thread([future = release_async()]() mutable { future.get(); }).detach();
+  }
+}
+
+template <typename T>
+inline ProcletStream<T>::operator bool() const {
+  return state_addr_;
+}
+
+template <typename T>
+Future<void> ProcletStream<T>::release_async() {
+  // Ordered after all previously issued calls.
+  auto future = proclet_.run_async(
+      +[](T &, uintptr_t state_addr, uint64_t seq) {
+        auto *state = reinterpret_cast<State *>(state_addr);
+        state->wait_for_turn(seq);
+        delete state;
+      },
+      state_addr_, next_seq_++);
+  state_addr_ = 0;
+  return future;
+}
+
+template <typename T>
+void ProcletStream<T>::reset() {
+  if (state_addr_) {
+    release_async().get();
+  }
+}
+
+template <typename T>
+template <typename RetT, typename... S0s, typename... S1s>
+Future<RetT> ProcletStream<T>::run_async(RetT (*fn)(T &, S0s...),
+                                         S1s &&...states)
+  requires ValidInvocationTypes<RetT, S0s...>
+{
+  using fn_states_checker [[maybe_unused]] =
+      decltype(fn(std::declval<T &>(), std::move(states)...));
+  BUG_ON(!state_addr_);
+
+  auto fn_addr = reinterpret_cast<uintptr_t>(fn);
+  auto *proxy_fn = +[](T &t, uintptr_t state_addr, uint64_t seq,
+                       uintptr_t fn_addr, S0s... states) {
+    auto *state = reinterpret_cast<State *>(state_addr);
+    state->wait_for_turn(seq);
+    auto finisher =
+        std::experimental::scope_exit([&] { state->finish_turn(); });
+    return reinterpret_cast<decltype(fn)>(fn_addr)(t, std::move(states)...);
+  };
+  // The sequence number is assigned at issuing time, so the calls can be
+  // sent out concurrently.
+  return proclet_.run_async(proxy_fn, state_addr_, next_seq_++, fn_addr,
+                            std::forward<S1s>(states)...);
+}
+
+template <typename T>
+template <typename RetT, typename... S0s, typename... S1s>
+RetT ProcletStream<T>::run(RetT (*fn)(T &, S0s...), S1s &&...states)
+  requires ValidInvocationTypes<RetT, S0s...>
+{
+  auto future = run_async(fn, std::forward<S1s>(states)...);
+  if constexpr (std::is_void_v<RetT>) {
+    future.get();
+  } else {
+    return std::move(future.get());
+  }
+}
+
+template <typename T>
+template <typename RetT, typename... A0s, typename... A1s>
+Future<RetT> ProcletStream<T>::run_async(RetT (T::*md)(A0s...),
+                                         A1s &&...args)
+  requires ValidInvocationTypes<RetT, A0s...>
+{
+  using md_args_checker [[maybe_unused]] =
+      decltype((std::declval<T>().*(md))(std::forward<A1s>(args)...));
+
+  MethodPtr<decltype(md)> method_ptr;
+  method_ptr.ptr = md;
+  return run_async(
+      +[](T &t, decltype(method_ptr) method_ptr, A0s... args) {
+        return (t.*(method_ptr.ptr))(std::move(args)...);
+      },
+      method_ptr, std::forward<A1s>(args)...);
+}
+
+template <typename T>
+template <typename RetT, typename... A0s, typename... A1s>
+RetT ProcletStream<T>::run(RetT (T::*md)(A0s...), A1s &&...args)
+  requires ValidInvocationTypes<RetT, A0s...>
+{
+  auto future = run_async(md, std::forward<A1s>(args)...);
+  if constexpr (std::is_void_v<RetT>) {
+    future.get();
+  } else {
+    return std::move(future.get());
+  }
+}
+
+template <typename T>
+inline ProcletStream<T> Proclet<T>::stream() {
+  return ProcletStream<T>(get_weak());
+}
+
+}  // namespace nu
@@ -0,0 +1,275 @@
+#include <utility>
+
+#include "nu/resource_reporter.hpp"
+#include "nu/runtime.hpp"
+#include "nu/utils/caladan.hpp"
+#include "nu/utils/future.hpp"
+#include "nu/utils/scoped_lock.hpp"
+
+namespace nu {
+
+template <typename T>
+inline ReplicatedProclet<T>::Replica::Replica(T t)
+    : obj(std::move(t)), retired(false) {}
+
+template <typename T>
+template <typename... As>
+inline ReplicatedProclet<T>::Primary::Primary(std::optional<uint64_t> capacity,
+                                              As &&...args)
+    : obj(std::forward<As>(args)...), capacity(capacity) {}
+
+template <typename T>
+template <typename RetT, typename... S0s>
+RetT ReplicatedProclet<T>::Primary::write(uintptr_t fn_addr, S0s... states) {
+  using Fn = RetT (*)(T &, S0s...);
+
+  ScopedLock<Mutex> lock(&mutex);
+
+  std::vector<Future<void>> futures;
+  futures.reserve(replicas.size());
+  for (auto &replica : replicas) {
+    futures.emplace_back(replica.run_async(
+        +[](Replica &r, uintptr_t fn_addr, S0s... states) {
+          r.lock.writer_lock();
+          reinterpret_cast<Fn>(fn_addr)(r.obj, std::move(states)...);
+          r.lock.writer_unlock();
+        },
+        fn_addr, states...));
+  }
+
+  if constexpr (std::is_void_v<RetT>) {
+    lock.writer_lock();
+    reinterpret_cast<Fn>(fn_addr)(obj, std::move(states)...);
+    lock.writer_unlock();
+    for (auto &future : futures) {
+      future.get();
+    }
+  } else {
+    lock.writer_lock();
+    auto ret = reinterpret_cast<Fn>(fn_addr)(obj, std::move(states)...);
+    lock.writer_unlock();
+    for (auto &future : futures) {
+      future.get();
+    }
+    return ret;
+  }
+}
+
+template <typename T>
+inline ReplicatedProclet<T>::operator bool() const {
+  return static_cast<bool>(primary_);
+}
+
+template <typename T>
+template <typename RetT, typename... S0s, typename... S1s>
+RetT ReplicatedProclet<T>::read(uintptr_t fn_addr, S1s &&...states) {
+  using Fn = RetT (*)(const T &, S0s...);
+
+  if (!primary_.is_local()) {
+    for (auto &replica : replicas_) {
+      if (!replica.is_local()) {
+        continue;
+      }
+
+      if constexpr (std::is_void_v<RetT>) {
+        auto served = replica.run(
+            +[](Replica &r, uintptr_t fn_addr, S0s... states) {
+              r.lock.reader_lock();
+              bool retired = r.retired;
+              if (likely(!retired)) {
+                reinterpret_cast<Fn>(fn_addr)(r.obj, std::move(states)...);
+              }
+              r.lock.reader_unlock();
+              return !retired;
+            },
+            fn_addr, states...);
+        if (likely(served)) {
+          return;
+        }
+      } else {
+        auto ret = replica.run(
+            +[](Replica &r, uintptr_t fn_addr,
+                S0s... states) -> std::optional<RetT> {
+              std::optional<RetT> ret;
+              r.lock.reader_lock();
+              if (likely(!r.retired)) {
+                ret = reinterpret_cast<Fn>(fn_addr)(r.obj,
+                                                    std::move(states)...);
+              }
+              r.lock.reader_unlock();
+              return ret;
+            },
+            fn_addr, states...);
+        if (likely(ret)) {
+          return std::move(*ret);
+        }
+      }
+
+      // The replica has been retired.
+      refresh();
+      break;
+    }
+  }
+
+  return primary_.run(
+      +[](Primary &p, uintptr_t fn_addr, S0s... states) {
+        p.lock.reader_lock();
+        if constexpr (std::is_void_v<RetT>) {
+          reinterpret_cast<Fn>(fn_addr)(p.obj, std::move(states)...);
+          p.lock.reader_unlock();
+        } else {
+          auto ret = reinterpret_cast<Fn>(fn_addr)(p.obj, std::move(states)...);
+          p.lock.reader_unlock();
+          return ret;
+        }
+      },
+      fn_addr, std::forward<S1s>(states)...);
+}
+
+template <typename T>
+template <typename RetT, typename... S0s, typename... S1s>
+RetT ReplicatedProclet<T>::run(RetT (*fn)(const T &, S0s...),
+                               S1s &&...states)
+  requires ValidInvocationTypes<RetT, S0s...>
+{
+  using fn_states_checker [[maybe_unused]] =
+      decltype(fn(std::declval<const T &>(), std::move(states)...));
+
+  auto fn_addr = reinterpret_cast<uintptr_t>(fn);
+  return read<RetT, S0s...>(fn_addr, std::forward<S1s>(states)...);
+}
+
+template <typename T>
+template <typename RetT, typename... S0s, typename... S1s>
+RetT ReplicatedProclet<T>::run(RetT (*fn)(T &, S0s...), S1s &&...states)
+  requires ValidInvocationTypes<RetT, S0s...>
+{
+  using fn_states_checker [[maybe_unused]] =
+      decltype(fn(std::declval<T &>(), std::move(states)...));
+
+  auto fn_addr = reinterpret_cast<uintptr_t>(fn);
+  return primary_.run(
+      +[](Primary &p, uintptr_t fn_addr, S0s... states) {
+        return p.template write<RetT, S0s...>(fn_addr, std::move(states)...);
+      },
+      fn_addr, std::forward<S1s>(states)...);
+}
+
+template <typename T>
+template <typename RetT, typename... A0s, typename... A1s>
+RetT ReplicatedProclet<T>::run(RetT (T::*md)(A0s...) const, A1s &&...args)
+  requires ValidInvocationTypes<RetT, A0s...>
+{
+  using md_args_checker [[maybe_unused]] =
+      decltype((std::declval<const T>().*(md))(std::forward<A1s>(args)...));
+
+  MethodPtr<decltype(md)> method_ptr;
+  method_ptr.ptr = md;
+  return run(
+      +[](const T &t, decltype(method_ptr) method_ptr, A0s... args) {
+        return (t.*(method_ptr.ptr))(std::move(args)...);
+      },
+      method_ptr, std::forward<A1s>(args)...);
+}
+
+template <typename T>
+template <typename RetT, typename... A0s, typename... A1s>
+RetT ReplicatedProclet<T>::run(RetT (T::*md)(A0s...), A1s &&...args)
+  requires ValidInvocationTypes<RetT, A0s...>
+{
+  using md_args_checker [[maybe_unused]] =
+      decltype((std::declval<T>().*(md))(std::forward<A1s>(args)...));
+
+  MethodPtr<decltype(md)> method_ptr;
+  method_ptr.ptr = md;
+  return run(
+      +[](T &t, decltype(method_ptr) method_ptr, A0s... args) {
+        return (t.*(method_ptr.ptr))(std::move(args)...);
+      },
+      method_ptr, std::forward<A1s>(args)...);
+}
+
+template <typename T>
+void ReplicatedProclet<T>::add_replica(std::optional<NodeIP> ip_hint) {
+  primary_.run(
+      +[](Primary &p, std::optional<NodeIP> ip_hint) {
+        ScopedLock<Mutex> lock(&p.mutex);
+        p.replicas.emplace_back(make_proclet<Replica>(
+            std::make_tuple(p.obj), /* pinned = */ false, p.capacity, ip_hint));
+      },
+      ip_hint);
+  refresh();
+}
+
+template <typename T>
+void ReplicatedProclet<T>::retire_replica() {
+  primary_.run(+[](Primary &p) {
+    ScopedLock<Mutex> lock(&p.mutex);
+    if (p.replicas.empty()) {
+      return;
+    }
+    auto replica = std::move(p.replicas.back());
+    p.replicas.pop_back();
+    // Stops serving reads; it gets destroyed once all handles drop it.
+    replica.run(+[](Replica &r) {
+      r.lock.writer_lock();
+      r.retired = true;
+      r.lock.writer_unlock();
+    });
+  });
+  refresh();
+}
+
+template <typename T>
+inline uint32_t ReplicatedProclet<T>::num_replicas() const {
+  return replicas_.size();
+}
+
+template <typename T>
+void ReplicatedProclet<T>::refresh() {
+  replicas_ = primary_.run(+[](Primary &p) {
+    ScopedLock<Mutex> lock(&p.mutex);
+    return p.replicas;
+  });
+}
+
+template <typename T>
+template <class Archive>
+inline void ReplicatedProclet<T>::serialize(Archive &ar) {
+  ar(primary_, replicas_);
+}
+
+template <typename T, typename... As>
+ReplicatedProclet<T> make_replicated_proclet(
+    std::tuple<As...> args_tuple, std::optional<uint32_t> num_replicas,
+    std::optional<uint64_t> capacity) {
+  using Primary = ReplicatedProclet<T>::Primary;
+
+  std::vector<std::pair<NodeIP, Resource>> global_free_resources;
+  {
+    Caladan::PreemptGuard g;
+    global_free_resources =
+        get_runtime()->resource_reporter()->get_global_free_resources();
+  }
+  BUG_ON(global_free_resources.empty());
+  auto num_nodes = global_free_resources.size();
+
+  ReplicatedProclet<T> replicated_proclet;
+  replicated_proclet.primary_ = std::apply(
+      [&](auto &&...args) {
+        return make_proclet<Primary>(
+            std::make_tuple(capacity, std::move(args)...),
+            /* pinned = */ false, capacity,
+            global_free_resources.front().first);
+      },
+      std::move(args_tuple));
+
+  auto n = num_replicas.value_or(num_nodes - 1);
+  for (uint32_t i = 0; i < n; i++) {
+    replicated_proclet.add_replica(
+        global_free_resources[(i + 1) % num_nodes].first);
+  }
+  return replicated_proclet;
+}
+
+}  // namespace nu
@@ -10,7 +10,7 @@ class RPCServerWorker {
 
   // Sends the return results of an RPC.
   void Return(RPCReturnCode rc, RPCReturnBuffer &&buf,
-              std::size_t completion_data);
+              std::size_t completion_data, RPCPriority priority);
   
   // Expose the TcpConn for an accessor on the local/remote IP addresses
   ConnAddrPair GetRPCConnAddrPair();
@@ -26,6 +26,7 @@ class RPCServerWorker {
     RPCReturnCode rc;
     RPCReturnBuffer buf;
     std::size_t completion_data;
+    RPCPriority priority;
   };
 
   rt::Spin lock_;
@@ -42,9 +43,10 @@ class RPCServerWorker {
 };
 
 inline void RPCServerWorker::Return(RPCReturnCode rc, RPCReturnBuffer &&buf,
-                                    std::size_t completion_data) {
+                                    std::size_t completion_data,
+                                    RPCPriority priority) {
   rt::SpinGuard guard(&lock_);
-  completions_.emplace_back(rc, std::move(buf), completion_data);
+  completions_.emplace_back(rc, std::move(buf), completion_data, priority);
   wake_sender_.Wake();
 }
 
@@ -58,16 +60,22 @@ inline netaddr RPCServerWorker::GetRemoteAddr() {
   return this->c_->RemoteAddr();
 }
 
-inline void RPCFlow::Call(std::span<const std::byte> src, RPCCompletion *c) {
+inline void RPCFlow::Call(std::span<const std::byte> src, RPCCompletion *c,
+                          RPCPriority priority) {
   rt::SpinGuard guard(&lock_);
-  reqs_.emplace(req_ctx{src, c});
+  reqs_[priority].emplace(req_ctx{src, c, priority});
+  num_queued_reqs_++;
   if (sent_count_ - recv_count_ < credits_) wake_sender_.Wake();
 }
 
 }  // namespace rpc_internal
 
-inline RPCReturner::RPCReturner(void *rpc_server, std::size_t completion_data)
-    : rpc_server_(rpc_server), completion_data_(completion_data) {
+inline RPCReturner::RPCReturner(void *rpc_server, std::size_t completion_data,
+                                RPCPriority priority, uint64_t recv_tsc)
+    : priority(priority),
+      recv_tsc(recv_tsc),
+      rpc_server_(rpc_server),
+      completion_data_(completion_data) {
   auto server = reinterpret_cast<rpc_internal::RPCServerWorker *>(rpc_server);
   this->local_addr = server->GetLocalAddr();
   this->remote_addr = server->GetRemoteAddr();
@@ -80,13 +88,13 @@ inline void RPCReturner::Return(RPCReturnCode rc,
   auto rpc_server =
       reinterpret_cast<rpc_internal::RPCServerWorker *>(rpc_server_);
   rpc_server->Return(rc, RPCReturnBuffer(buf, std::move(deleter_fn)),
-                     completion_data_);
+                     completion_data_, priority);
 }
 
 inline void RPCReturner::Return(RPCReturnCode rc) {
   auto rpc_server =
       reinterpret_cast<rpc_internal::RPCServerWorker *>(rpc_server_);
-  rpc_server->Return(rc, RPCReturnBuffer(), completion_data_);
+  rpc_server->Return(rc, RPCReturnBuffer(), completion_data_, priority);
 }
 
 inline ConnAddrPair RPCReturner::GetRPCAddrPair() {
@@ -105,23 +113,25 @@ inline netaddr RPCReturner::GetRemoteAddr() {
 }
 
 inline RPCReturnCode RPCClient::Call(std::span<const std::byte> args,
-                                     RPCCallback &&callback) {
+                                     RPCCallback &&callback,
+                                     RPCPriority priority) {
   std::span<const std::byte> full_args = args;
   RPCCompletion completion(std::move(callback));
   {
     rt::Preempt p;
     if (!p.IsHeld()) {
       rt::PreemptGuardAndPark guard(&p);
-      flows_[p.get_cpu()]->Call(full_args, &completion);
+      flows_[p.get_cpu()]->Call(full_args, &completion, priority);
     } else {
-      flows_[p.get_cpu()]->Call(full_args, &completion);
+      flows_[p.get_cpu()]->Call(full_args, &completion, priority);
     }
   }
   return completion.get_return_code();
 }
 
 inline RPCReturnCode RPCClient::Call(std::span<const std::byte> args,
-                                     RPCReturnBuffer *return_buf) {
+                                     RPCReturnBuffer *return_buf,
+                                     RPCPriority priority) {
   std::span<const std::byte> full_args = args;
 
   RPCCompletion completion(return_buf);
@@ -129,9 +139,9 @@ inline RPCReturnCode RPCClient::Call(std::span<const std::byte> args,
     rt::Preempt p;
     if (!p.IsHeld()) {
       rt::PreemptGuardAndPark guard(&p);
-      flows_[p.get_cpu()]->Call(full_args, &completion);
+      flows_[p.get_cpu()]->Call(full_args, &completion, priority);
     } else {
-      flows_[p.get_cpu()]->Call(full_args, &completion);
+      flows_[p.get_cpu()]->Call(full_args, &completion, priority);
     }
   }
   return completion.get_return_code();
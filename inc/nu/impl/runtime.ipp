@@ -189,6 +189,10 @@ inline std::optional<MigrationGuard> Runtime::__attach_and_disable_migration(
 
 inline std::optional<MigrationGuard> Runtime::attach_and_disable_migration(
     ProcletHeader *proclet_header) {
+  if (unlikely(proclet_header->status() == kSpilled)) {
+    proclet_manager_->reload(proclet_header);
+  }
+
   Caladan::PreemptGuard g;
 
   assert(!caladan_->thread_get_owner_proclet());
@@ -201,6 +205,10 @@ inline std::optional<MigrationGuard> Runtime::attach_and_disable_migration(
 
 inline std::optional<MigrationGuard> Runtime::reattach_and_disable_migration(
     ProcletHeader *new_header, const MigrationGuard &old_guard) {
+  if (unlikely(new_header->status() == kSpilled)) {
+    proclet_manager_->reload(new_header);
+  }
+
   Caladan::PreemptGuard g;
 
   auto *old_header = old_guard.header();
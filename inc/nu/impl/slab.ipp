@@ -85,4 +85,17 @@ inline void SlabAllocator::deregister_slab_by_id(SlabId_t slab_id) {
 
 inline uint64_t SlabAllocator::FreePtrsLinkedList::size() { return size_; }
 
+template <typename F>
+inline void SlabAllocator::FreePtrsLinkedList::for_each(F &&f) {
+  for (auto *batch = head_; batch;
+       batch = reinterpret_cast<Batch *>(batch->p[0])) {
+    f(batch);
+    for (uint32_t i = 1; i < kBatchSize; i++) {
+      if (batch->p[i]) {
+        f(batch->p[i]);
+      }
+    }
+  }
+}
+
 }  // namespace nu
@@ -0,0 +1,68 @@
+#include <algorithm>
+
+extern "C" {
+#include <base/time.h>
+#include <runtime/preempt.h>
+#include <runtime/thread.h>
+}
+#include <timer.h>
+
+#include "nu/commons.hpp"
+#include "nu/utils/scoped_lock.hpp"
+
+namespace nu {
+
+inline TokenBucket::TokenBucket(uint64_t rate_bytes_per_s,
+                                uint64_t burst_bytes)
+    : rate_(rate_bytes_per_s),
+      burst_(burst_bytes),
+      tokens_(burst_bytes),
+      last_refill_us_(microtime()) {}
+
+inline void TokenBucket::refill(uint64_t now_us) {
+  auto elapsed_us = now_us - last_refill_us_;
+  last_refill_us_ = now_us;
+  tokens_ = std::min(static_cast<double>(burst_),
+                     tokens_ + static_cast<double>(elapsed_us) * rate_ /
+                                   kOneSecond);
+}
+
+inline void TokenBucket::set_rate(uint64_t rate_bytes_per_s) {
+  ScopedLock lock(&spin_);
+  refill(microtime());
+  rate_ = rate_bytes_per_s;
+}
+
+inline uint64_t TokenBucket::get_rate() const {
+  return rt::access_once(rate_);
+}
+
+inline void TokenBucket::consume(uint64_t bytes) {
+  uint64_t wait_us;
+  {
+    ScopedLock lock(&spin_);
+    if (!rate_) {
+      return;
+    }
+    refill(microtime());
+    tokens_ -= bytes;
+    if (tokens_ >= 0) {
+      return;
+    }
+    wait_us = -tokens_ * kOneSecond / rate_;
+  }
+  if (preempt_enabled()) {
+    rt::Sleep(wait_us);
+    return;
+  }
+
+  // The pressure handler and its aux handlers must not park, so they spin
+  // while letting the other work of their kthread run.
+  auto deadline_us = microtime() + wait_us;
+  while (microtime() < deadline_us) {
+    unblock_spin();
+    cpu_relax();
+  }
+}
+
+}  // namespace nu
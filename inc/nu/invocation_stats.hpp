@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "nu/commons.hpp"
+#include "nu/utils/latency_histogram.hpp"
+
+namespace nu {
+
+// Per-method invocation accounting of a proclet. It is allocated on the
+// proclet's own heap once enabled, so it follows the proclet across
+// migrations. Methods are keyed by their method pointers, or by the function
+// pointers for closures. Queueing time is only measured for remote calls,
+// i.e., from receiving the RPC to starting the handler; serialization time
+// covers decoding the arguments and encoding the return value remotely, and
+// passing the return value back to the caller locally.
+class InvocationStats {
+ public:
+  constexpr static uint32_t kMaxNumMethods = 32;
+
+  struct MethodStats {
+    uintptr_t method;
+    // Time elapsed since the stats were last reset.
+    uint64_t duration_us;
+    LatencyHistogram::Snapshot queueing;
+    LatencyHistogram::Snapshot execution;
+    LatencyHistogram::Snapshot serialization;
+
+    uint64_t num_calls() const;
+    double calls_per_sec() const;
+  };
+
+  struct Entry {
+    std::atomic<uintptr_t> method;
+    LatencyHistogram queueing;
+    LatencyHistogram execution;
+    LatencyHistogram serialization;
+  };
+
+  InvocationStats();
+  // Returns nullptr if the table is full.
+  Entry *get_entry(uintptr_t method);
+  std::vector<MethodStats> get_all() const;
+  void reset();
+  template <typename Fn>
+  static uintptr_t to_method_key(Fn fn);
+  template <typename FnPtr, typename... Ss>
+  static uintptr_t to_method_key(FnPtr fn, const std::tuple<Ss...> &states);
+
+ private:
+  Entry entries_[kMaxNumMethods];
+  std::atomic<uint64_t> reset_us_;
+};
+
+}  // namespace nu
+
+#include "nu/impl/invocation_stats.ipp"
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <set>
 #include <span>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -19,8 +22,13 @@ extern "C" {
 #include "nu/ctrl_client.hpp"
 #include "nu/rpc_server.hpp"
 #include "nu/utils/archive_pool.hpp"
+#include "nu/utils/cond_var.hpp"
+#include "nu/utils/dirty_page_tracker.hpp"
+#include "nu/utils/migration_cost_model.hpp"
+#include "nu/utils/migration_tracer.hpp"
 #include "nu/utils/rpc.hpp"
 #include "nu/utils/slab.hpp"
+#include "nu/utils/token_bucket.hpp"
 
 namespace nu {
 
@@ -33,6 +41,8 @@ class MigrationGuard;
 enum MigratorTCPOp_t {
   kCopyProclet,
   kSkipProclet,
+  kPreCopyProclet,
+  kCopyProcletDelta,
   kMigrate,
   kEnablePoll,
   kDisablePoll,
@@ -101,27 +111,134 @@ class MigratorConnManager {
   void put(uint32_t ip, rt::TcpConn *tcp_conn);
 };
 
+// Gathers the messages of several migrating proclets so that they go out in
+// one vectored write. Written data is copied, except for write_ref(), whose
+// data must stay intact until flush().
+class MigrationBatchWriter {
+ public:
+  constexpr static uint64_t kArenaBlockSize = 64 << 10;
+
+  MigrationBatchWriter(rt::TcpConn *c);
+  ssize_t WriteFull(const void *buf, size_t len, bool nt = false,
+                    bool poll = false);
+  template <std::size_t Extent>
+  ssize_t WritevFull(std::span<const iovec, Extent> iov, bool nt = false,
+                     bool poll = false);
+  void write_copy(const void *buf, size_t len);
+  void write_ref(const void *buf, size_t len);
+  netaddr RemoteAddr() const;
+  uint64_t size() const;
+  void flush();
+
+ private:
+  rt::TcpConn *c_;
+  std::vector<std::unique_ptr<uint8_t[]>> arena_blocks_;
+  uint64_t arena_used_ = 0;
+  uint64_t arena_capacity_ = 0;
+  std::vector<iovec> iovecs_;
+  uint64_t size_ = 0;
+
+  void append(const void *buf, size_t len);
+};
+
 class Migrator {
  public:
-  constexpr static uint32_t kTransmitProcletNumThreads = 3;
+  // Proclets are split into parallel streams of at least kMinStripeSize
+  // bytes each, one per aux pressure handler plus the main one.
+  constexpr static uint32_t kMaxTransmitProcletNumThreads = 8;
+  constexpr static uint64_t kMinStripeSize = 16 * kOneMB;
   constexpr static uint32_t kDefaultNumReservedConns = 8;
   constexpr static uint32_t kPort = 8002;
-  constexpr static float kMigrationThrottleGBs = 0;
+  // Migrations to all destinations share a per-node bandwidth budget, which
+  // is taken in quanta as the data goes out. While foreground invocations are
+  // slower than the target, the budget backs off multiplicatively, and
+  // otherwise recovers additively up to the configured rate.
+  constexpr static uint64_t kBandwidthBudgetQuantum = kOneMB;
+  constexpr static uint64_t kBandwidthBudgetBurst = 4 * kOneMB;
+  constexpr static uint32_t kBandwidthBudgetAdjustIntervalUs = 1000;
+  constexpr static uint32_t kBandwidthBudgetRecoverySteps = 16;
+  // Servers are usually killed rather than shut down, so traces are flushed
+  // periodically as well.
+  constexpr static uint64_t kTraceFlushIntervalUs = kOneSecond;
+  constexpr static float kMinBandwidthBudgetGBs = 0.1;
+  constexpr static uint32_t kForegroundLatencyTargetUs = 200;
   constexpr static uint32_t kMigrationDelayUs = 0;
   constexpr static uint32_t kRCUWaitTimeoutUs = 30;
   constexpr static uint32_t kTCPListenBackLog = 64;
+  // Pre-copy sends the heap while the proclet keeps running and then resends
+  // the dirtied pages for a few rounds, so that the proclet is only paused
+  // for the final delta. The rounds skip pages whose content hash is
+  // unchanged; the final delta does not. Dirty pages are tracked through
+  // DirtyPageTracker, which writes /proc/self/clear_refs for the whole
+  // process and does blocking open()/pread() calls on /proc/self/pagemap from
+  // within __migrate().
+  constexpr static bool kEnablePreCopy = true;
+  constexpr static uint64_t kPreCopyMinHeapSize = 64 * kOneMB;
+  constexpr static uint32_t kPreCopyMaxRounds = 4;
+  constexpr static uint64_t kPreCopyStopBytes = 4 * kOneMB;
+  constexpr static uint64_t kPreCopyBatchSize = 4 * kOneMB;
+  // Free slab regions of at least this size are not sent.
+  constexpr static uint64_t kMinSkippedFreeRegionSize = 64 << 10;
+  // Proclets up to this size are migrated in batches that share one write,
+  // skipping pre-copy, striping and the aux handlers.
+  constexpr static uint64_t kMaxCoalescedProcletSize = kOneMB;
+  constexpr static uint64_t kMaxCoalescedBatchSize = 16 * kOneMB;
+  // New locations are published to the controller in the background, once
+  // the proclets have resumed; forwarding covers callers meanwhile.
+  constexpr static uint32_t kMaxLocationUpdatesBatchSize = 256;
+  // Requests that arrive for a proclet while it is being migrated are held at
+  // the source until its state has been handed over, and then all get
+  // redirected to the destination at once. Those that reach the destination
+  // before it is done loading the proclet are held there too, and then sent
+  // back to it. Otherwise they bounce right away and their callers keep
+  // retrying against the stale location.
+  constexpr static bool kHoldRequestsDuringMigration = true;
+  // Paused threads are shipped in batches of vectored writes, with the nu
+  // states of a batch ahead of its stacks.
+  constexpr static uint64_t kThreadBatchSize = 128;
+  // Incoming heaps are pre-faulted in chunks by parallel threads, ahead of
+  // the data stream. Chunks are multiples of the huge page size.
+  constexpr static uint64_t kPopulateChunkSize = 32 * kOneMB;
+  constexpr static uint32_t kMaxNumPopulateThreads = 4;
+  // A pressure episode spreads its proclets over up to this many destinations
+  // that are migrated to in parallel. Another destination is only acquired
+  // once the ones in use are expected to take longer than the threshold.
+  // Soft-dirty bits are process-wide, so only one destination at a time gets
+  // to pre-copy; the proclets of the others are stopped and copied whole.
+  constexpr static uint32_t kMaxNumMigrationDests = 4;
+  constexpr static float kMinParallelMigrationUs = 2000;
+
+  static_assert(kMaxTransmitProcletNumThreads > 1);
 
-  static_assert(kTransmitProcletNumThreads > 1);
+  struct CopyChunk {
+    uint64_t addr;
+    uint64_t len;
+    const void *src;
+  };
 
   Migrator();
   ~Migrator();
   uint32_t migrate(
       const std::vector<std::pair<ProcletMigrationTask, Resource>> &tasks);
   void reserve_conns(uint32_t dest_server_ip);
+  // 0 means unlimited.
+  void set_bandwidth_budget(float gbs);
+  float get_bandwidth_budget();
+  void report_foreground_latency(uint64_t latency_tsc);
+  MigrationTracer *tracer();
+  MigrationCostModel *cost_model();
+  // Dumps the traced migrations to <path>.txt and <path>.json every
+  // kTraceFlushIntervalUs and on exit. An empty path disables the dump.
+  void set_trace_path(std::string path);
+  void dump_trace();
+  void transmit_budgeted(rt::TcpConn *c, std::span<const iovec> iovecs,
+                         bool nt, bool poll = true);
   void forward_to_original_server(RPCReturnCode rc, RPCReturner *returner,
                                   uint64_t payload_len, const void *payload,
                                   ArchivePool<>::IASStream *ia_sstream);
   void forward_to_client(RPCReqForward &req);
+  // Returns once the proclet is not being populated or loaded here.
+  void wait_until_loaded(ProcletHeader *proclet_header);
   template <typename RetT>
   static MigrationGuard migrate_thread_and_ret_val(
       RPCReturnBuffer &&ret_val_buf, ProcletID dest_id, RetT *dest_ret_val_ptr,
@@ -138,27 +255,110 @@ class Migrator {
   bool callback_triggered_;
   std::unordered_set<uint32_t> delayed_srv_ips_;
   std::vector<thread_t *> threads_to_wakeup_;
+  MigrationTracer tracer_;
+  MigrationCostModel cost_model_;
+  std::string trace_path_;
+  rt::Mutex trace_dump_mutex_;
+  bool trace_flusher_done_ = false;
+  rt::Thread trace_flusher_;
+  TokenBucket bandwidth_budget_{0, kBandwidthBudgetBurst};
+  float max_bandwidth_budget_gbs_ = 0;
+  std::atomic<uint32_t> num_budgeted_transfers_{0};
+  std::atomic<uint64_t> foreground_latency_tsc_{0};
+  std::atomic<uint64_t> last_budget_adjust_us_{0};
+  // Signaled whenever an incoming proclet leaves kPopulating.
+  SpinLock loading_spin_;
+  CondVar loading_cond_var_;
+  rt::Spin location_updates_spin_;
+  std::vector<ProcletLocationUpdate> pending_location_updates_;
+  // Concurrent migrations share the aux handlers and the runtime's list of
+  // paused threads, so their stop-and-copy phases are serialized. Waiters keep
+  // serving pause requests instead of parking, as the pressure handler must
+  // not park. The aux handlers poll the connections to one destination at a
+  // time.
+  class StopCopyLock {
+   public:
+    void lock();
+    void unlock();
+
+   private:
+    SpinLock spin_;
+  };
+  StopCopyLock stop_copy_lock_;
+  std::atomic<NodeIP> aux_handlers_dest_ip_{0};
+  struct MigrationLane {
+    std::unique_ptr<std::pair<NodeGuard, Resource>> dest;
+    MigrationCostModel::Params cost;
+    Resource used;
+    float estimated_us;
+    std::vector<std::pair<ProcletMigrationTask, Resource>> tasks;
+  };
   rt::Thread th_;
 
   void run_background_loop();
-  void handle_copy_proclet(rt::TcpConn *c);
+  uint32_t handle_copy_proclet(rt::TcpConn *c);
+  uint32_t handle_copy_proclet_chunks(rt::TcpConn *c, bool is_final);
   void handle_load(rt::TcpConn *c);
   void handle_register_callback(rt::TcpConn *c);
   void handle_deregister_callback(rt::TcpConn *c);
   VAddrRange load_stack_cluster_mmap_task(rt::TcpConn *c);
-  void transmit(rt::TcpConn *c, ProcletHeader *proclet_header,
-                struct list_head *head);
+  struct PreCopyState {
+    DirtyPageTracker tracker;
+    uint32_t generation;
+    // End of the heap range that has been sent.
+    uint64_t end_addr;
+    // Heap bytes sent by all rounds.
+    uint64_t sent_len;
+    // Hashes of the page contents last sent by the pre-copy rounds.
+    std::unordered_map<uint64_t, uint64_t> page_hashes;
+  };
+
+  // Returns the heap bytes written to c during the pause, if the proclet did
+  // not go through the batch.
+  uint64_t transmit(rt::TcpConn *c, ProcletHeader *proclet_header,
+                    struct list_head *head, PreCopyState *precopy_state,
+                    MigrationBatchWriter *batch, MigrationRecord *record);
+  void transmit_small_proclet(MigrationBatchWriter *batch,
+                              ProcletHeader *proclet_header);
+  bool is_coalescable(ProcletHeader *proclet_header);
   void update_proclet_location(rt::TcpConn *c, ProcletHeader *proclet_header);
+  static void push_proclet_location(ProcletID id, ProcletLocation location,
+                                    const std::vector<NodeIP> &caller_ips);
+  void publish_proclet_locations();
+  void notify_loaded();
   void transmit_stack_cluster_mmap_task(rt::TcpConn *c);
-  void transmit_proclet(rt::TcpConn *c, ProcletHeader *proclet_header);
+  uint64_t transmit_proclet(rt::TcpConn *c, ProcletHeader *proclet_header,
+                            PreCopyState *precopy_state,
+                            MigrationRecord *record);
+  uint32_t get_num_stripes(rt::TcpConn *c, uint64_t len);
+  uint64_t transmit_whole_proclet(rt::TcpConn *c,
+                                  ProcletHeader *proclet_header,
+                                  MigrationRecord *record);
+  void transmit_chunks(rt::TcpConn *c, ProcletHeader *proclet_header,
+                       uint8_t type, const std::vector<CopyChunk> &chunks,
+                       uint32_t num_stripes, MigrationRecord *record = nullptr);
+  void trace_stripes(MigrationRecord *record, ProcletHeader *proclet_header,
+                     uint32_t num_stripes, uint64_t start_tsc);
+  std::unique_ptr<PreCopyState> precopy_proclet(rt::TcpConn *c,
+                                                ProcletHeader *proclet_header);
+  uint64_t precopy_round(rt::TcpConn *c, ProcletHeader *proclet_header,
+                         PreCopyState *state);
+  std::vector<CopyChunk> get_final_delta(ProcletHeader *proclet_header,
+                                         PreCopyState *state);
   void transmit_proclet_migration_tasks(
       rt::TcpConn *c, bool has_mem_pressure,
       const std::vector<ProcletMigrationTask> &tasks);
-  void transmit_mutexes(rt::TcpConn *c, std::vector<Mutex *> mutexes);
-  void transmit_condvars(rt::TcpConn *c, std::vector<CondVar *> condvars);
-  void transmit_time(rt::TcpConn *c, Time *time);
-  void transmit_threads(rt::TcpConn *c, const std::vector<thread_t *> &threads);
-  void transmit_one_thread(rt::TcpConn *c, thread_t *thread);
+  template <typename Conn>
+  void transmit_mutexes(Conn *c, std::vector<Mutex *> mutexes);
+  template <typename Conn>
+  void transmit_condvars(Conn *c, std::vector<CondVar *> condvars);
+  template <typename Conn>
+  void transmit_time(Conn *c, Time *time);
+  template <typename Conn>
+  void transmit_threads(Conn *c, const std::vector<thread_t *> &threads);
+  template <typename Conn>
+  void transmit_thread_batch(Conn *c, std::span<thread_t *const> threads);
+  void adjust_bandwidth_budget();
   bool try_mark_proclet_migrating(ProcletHeader *proclet_header);
   void load(rt::TcpConn *c);
   bool load_proclet(rt::TcpConn *c, ProcletHeader *proclet_header,
@@ -172,10 +372,14 @@ class Migrator {
   void load_time_and_mark_proclet_present(rt::TcpConn *c,
                                           ProcletHeader *proclet_header);
   void load_threads(rt::TcpConn *c, ProcletHeader *proclet_header);
-  thread_t *load_one_thread(rt::TcpConn *c, ProcletHeader *proclet_header);
-  void aux_handlers_enable_polling(uint32_t dest_ip);
+  std::vector<thread_t *> read_threads(rt::TcpConn *c);
+  bool aux_handlers_enable_polling(uint32_t dest_ip);
   void aux_handlers_disable_polling();
   void callback();
+  std::vector<MigrationLane> plan_migration_lanes(
+      bool mem_pressure,
+      std::vector<std::pair<ProcletMigrationTask, Resource>> *tasks,
+      const std::set<NodeIP> &congested_dests);
   uint32_t __migrate(const NodeGuard &dest_guard, bool mem_pressure,
                      const std::vector<ProcletMigrationTask> &tasks);
   void pause_migrating_threads(ProcletHeader *proclet_header);
@@ -5,6 +5,7 @@
 #include <cstddef>
 #include <memory>
 #include <set>
+#include <unordered_map>
 
 extern "C" {
 #include <runtime/pressure.h>
@@ -23,30 +24,46 @@ struct AuxHandlerState {
   bool pause = false;
   bool task_pending = false;
   bool done = false;
+  // When the last tcp write task ran.
+  uint64_t task_start_tsc = 0;
+  uint64_t task_end_tsc = 0;
 };
 
 struct Utility {
   Utility();
-  Utility(ProcletHeader *proclet_header, uint64_t mem_size, float cpu_load);
+  Utility(ProcletHeader *proclet_header, uint64_t mem_size, float cpu_load,
+          bool latency_critical, const MigrationCostModel::Params &cost);
 
-  constexpr static uint32_t kFixedCostUs = 25;
-  constexpr static uint32_t kNetBwGbps = 100;
   ProcletHeader *header;
   float mem_pressure_util;
   float cpu_pressure_util;
+  // Has recently served high-priority calls, so gets migrated last.
+  bool latency_critical;
+};
+
+struct ColdProclet {
+  ProcletHeader *header;
+  uint64_t idle_us;
+  float cpu_load;
 };
 
 class PressureHandler {
  public:
-  constexpr static uint32_t kNumAuxHandlers =
-      Migrator::kTransmitProcletNumThreads - 1;
+  constexpr static uint32_t kMaxNumAuxHandlers =
+      Migrator::kMaxTransmitProcletNumThreads - 1;
   constexpr static uint32_t kSortedProcletsUpdateIntervalUs =
       50 * kOneMilliSecond;
   constexpr static uint32_t kUpdateBudget = 200;
   constexpr static uint32_t kMinNumProcletsOnCPUPressure = 32;
+  // When migration cannot relieve memory pressure, proclets that have been
+  // idle for this long are spilled to local storage, the coldest first.
+  constexpr static uint64_t kMinSpillIdleUs = kOneSecond;
+  constexpr static uint64_t kMinSpillMemSize = kOneMB;
 
   PressureHandler();
   ~PressureHandler();
+  uint32_t get_num_aux_handlers() const;
+  std::pair<uint64_t, uint64_t> get_aux_task_tsc(uint32_t handler_id) const;
   void wait_aux_tasks();
   void update_aux_handler_state(uint32_t handler_id, MigratorConn &&conn);
   void dispatch_aux_tcp_task(uint32_t handler_id,
@@ -63,11 +80,17 @@ class PressureHandler {
  private:
   struct CmpMemUtil {
     bool operator()(const Utility &x, const Utility &y) const {
+      if (x.latency_critical != y.latency_critical) {
+        return y.latency_critical;
+      }
       return x.mem_pressure_util > y.mem_pressure_util;
     }
   };
   struct CmpCpuUtil {
     bool operator()(const Utility &x, const Utility &y) const {
+      if (x.latency_critical != y.latency_critical) {
+        return y.latency_critical;
+      }
       return x.cpu_pressure_util > y.cpu_pressure_util;
     }
   };
@@ -75,16 +98,36 @@ class PressureHandler {
       mem_pressure_sorted_proclets_;
   std::shared_ptr<std::multiset<Utility, CmpCpuUtil>>
       cpu_pressure_sorted_proclets_;
+  struct CmpColdness {
+    bool operator()(const ColdProclet &x, const ColdProclet &y) const {
+      if (x.idle_us != y.idle_us) {
+        return x.idle_us > y.idle_us;
+      }
+      return x.cpu_load < y.cpu_load;
+    }
+  };
+  std::shared_ptr<std::multiset<ColdProclet, CmpColdness>>
+      cold_sorted_proclets_;
+  // Since when each proclet has seen no invocation. Only touched by the
+  // update thread.
+  struct IdleState {
+    uint32_t generation;
+    uint64_t num_invocations;
+    uint64_t since_us;
+  };
+  std::unordered_map<ProcletHeader *, IdleState> idle_states_;
   rt::Thread update_th_;
   rt::Thread flush_th_;
   std::atomic<int> active_handlers_;
-  AuxHandlerState aux_handler_states_[kNumAuxHandlers];
+  AuxHandlerState aux_handler_states_[kMaxNumAuxHandlers];
+  uint32_t num_aux_handlers_;
   bool mock_;
   bool done_;
 
   std::vector<std::pair<ProcletMigrationTask, Resource>> pick_tasks(
       uint32_t min_num_proclets, uint32_t min_mem_mbs);
   void update_sorted_proclets();
+  void spill_cold_proclets(uint32_t min_mem_mbs);
   void register_handlers();
   void pause_aux_handlers();
   void __main_handler();
@@ -3,11 +3,14 @@
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <vector>
 
 #include "nu/commons.hpp"
+#include "nu/invocation_stats.hpp"
 #include "nu/task_range.hpp"
 #include "nu/type_traits.hpp"
 #include "nu/utils/future.hpp"
+#include "nu/utils/rpc.hpp"
 
 namespace nu {
 
@@ -17,6 +20,9 @@ class WeakProclet;
 template <typename T>
 class Proclet;
 
+template <typename T>
+class ProcletStream;
+
 template <typename... T>
 concept ValidInvocationTypes = requires {
   requires(!std::is_reference_v<T> && ... && true);
@@ -38,26 +44,37 @@ class Proclet {
   operator bool() const;
   bool operator==(const Proclet &) const;
   ProcletID get_id() const;
+  // Prio only applies to remote invocations; see RPCPriority.
   template <bool MigrEn = true, bool CPUMon = true, bool CPUSamp = true,
-            typename RetT, typename... S0s, typename... S1s>
+            RPCPriority Prio = kNormalPriority, typename RetT,
+            typename... S0s, typename... S1s>
   Future<RetT> run_async(RetT (*fn)(T &, S0s...), S1s &&...states)
     requires ValidInvocationTypes<RetT, S0s...>;
   template <bool MigrEn = true, bool CPUMon = true, bool CPUSamp = true,
-            typename RetT, typename... S0s, typename... S1s>
+            RPCPriority Prio = kNormalPriority, typename RetT,
+            typename... S0s, typename... S1s>
   RetT run(RetT (*fn)(T &, S0s...), S1s &&...states)
     requires ValidInvocationTypes<RetT, S0s...>;
   template <bool MigrEn = true, bool CPUMon = true, bool CPUSamp = true,
-            typename RetT, typename... A0s, typename... A1s>
+            RPCPriority Prio = kNormalPriority, typename RetT,
+            typename... A0s, typename... A1s>
   Future<RetT> run_async(RetT (T::*md)(A0s...), A1s &&...args)
     requires ValidInvocationTypes<RetT, A0s...>;
   template <bool MigrEn = true, bool CPUMon = true, bool CPUSamp = true,
-            typename RetT, typename... A0s, typename... A1s>
+            RPCPriority Prio = kNormalPriority, typename RetT,
+            typename... A0s, typename... A1s>
   RetT run(RetT (T::*md)(A0s...), A1s &&...args)
     requires ValidInvocationTypes<RetT, A0s...>;
   void reset();
   std::optional<Future<void>> reset_async();
   WeakProclet<T> get_weak() const;
   bool is_local() const;
+  ProcletStream<T> stream();
+  // Per-method invocation stats, which are off by default; see
+  // InvocationStats.
+  void enable_invocation_stats();
+  std::vector<InvocationStats::MethodStats> get_invocation_stats();
+  void reset_invocation_stats();
 
   template <class Archive>
   void save(Archive &ar) const;
@@ -84,26 +101,35 @@ class Proclet {
       std::function<void(int argc, char **argv)> main_func);
 
   std::optional<Future<void>> update_ref_cnt(ProcletID id, int delta);
-  template <typename... S1s>
+  template <RPCPriority Prio = kNormalPriority, typename... S1s>
   static void invoke_remote(MigrationGuard &&caller_guard, ProcletID id,
                             S1s &&...states);
-  template <typename RetT, typename... S1s>
+  template <typename RetT, RPCPriority Prio = kNormalPriority,
+            typename... S1s>
   static RetT invoke_remote_with_ret(MigrationGuard &&caller_guard,
                                      ProcletID id, S1s &&...states);
   template <typename... As>
   static Proclet __create(bool pinned, uint64_t capacity, NodeIP ip_hint,
                           As &&...args);
+  template <typename... As>
+  static std::vector<Proclet> __create_batch(uint32_t num, bool pinned,
+                                             uint64_t capacity, NodeIP ip_hint,
+                                             As &...args);
   template <bool MigrEn = true, bool CPUMon = true, bool CPUSamp = true,
-            typename RetT, typename... S0s, typename... S1s>
+            RPCPriority Prio = kNormalPriority, typename RetT,
+            typename... S0s, typename... S1s>
   Future<RetT> __run_async(RetT (*fn)(T &, S0s...), S1s &&...states);
   template <bool MigrEn = true, bool CPUMon = true, bool CPUSamp = true,
-            typename RetT, typename... S0s, typename... S1s>
+            RPCPriority Prio = kNormalPriority, typename RetT,
+            typename... S0s, typename... S1s>
   RetT __run(RetT (*fn)(T &, S0s...), S1s &&...states);
   template <bool MigrEn = true, bool CPUMon = true, bool CPUSamp = true,
-            typename RetT, typename... A0s, typename... A1s>
+            RPCPriority Prio = kNormalPriority, typename RetT,
+            typename... A0s, typename... A1s>
   Future<RetT> __run_async(RetT (T::*md)(A0s...), A1s &&...args);
   template <bool MigrEn = true, bool CPUMon = true, bool CPUSamp = true,
-            typename RetT, typename... A0s, typename... A1s>
+            RPCPriority Prio = kNormalPriority, typename RetT,
+            typename... A0s, typename... A1s>
   RetT __run(RetT (T::*md)(A0s...), A1s &&...args);
 
   template <typename U, typename... As>
@@ -120,6 +146,16 @@ class Proclet {
   template <typename U>
   friend Future<Proclet<U>> make_proclet_async(bool, std::optional<uint64_t>,
                                                std::optional<NodeIP>);
+  template <typename U, typename... As>
+  friend std::vector<Proclet<U>> make_proclets(uint32_t, std::tuple<As...>,
+                                               bool, std::optional<uint64_t>,
+                                               std::optional<NodeIP>);
+  template <typename U>
+  friend std::vector<Proclet<U>> make_proclets(uint32_t, bool,
+                                               std::optional<uint64_t>,
+                                               std::optional<NodeIP>);
+  template <typename U>
+  friend Proclet<U> restore_proclet(ProcletID);
 };
 
 template <typename T>
@@ -163,7 +199,36 @@ template <typename T>
 Future<Proclet<T>> make_proclet_async(
     bool pinned = false, std::optional<uint64_t> capacity = std::nullopt,
     std::optional<uint32_t> ip_hint = std::nullopt);
+// Creates num proclets with a single controller request and one batched
+// construction RPC per destination node. Each proclet gets its own copy of
+// args.
+template <typename T, typename... As>
+std::vector<Proclet<T>> make_proclets(
+    uint32_t num, std::tuple<As...> args_tuple, bool pinned = false,
+    std::optional<uint64_t> capacity = std::nullopt,
+    std::optional<uint32_t> ip_hint = std::nullopt);
+template <typename T, typename... As>
+Future<std::vector<Proclet<T>>> make_proclets_async(
+    uint32_t num, std::tuple<As...> args_tuple, bool pinned = false,
+    std::optional<uint64_t> capacity = std::nullopt,
+    std::optional<uint32_t> ip_hint = std::nullopt);
+template <typename T>
+std::vector<Proclet<T>> make_proclets(
+    uint32_t num, bool pinned = false,
+    std::optional<uint64_t> capacity = std::nullopt,
+    std::optional<uint32_t> ip_hint = std::nullopt);
+template <typename T>
+Future<std::vector<Proclet<T>>> make_proclets_async(
+    uint32_t num, bool pinned = false,
+    std::optional<uint64_t> capacity = std::nullopt,
+    std::optional<uint32_t> ip_hint = std::nullopt);
+// Returns a handle to a proclet restored from a checkpoint; see
+// ProcletManager::restore_checkpoints(). The handle takes over the reference
+// of the one that was around when the checkpoint got taken.
+template <typename T>
+Proclet<T> restore_proclet(ProcletID id);
 
 }  // namespace nu
 
 #include "nu/impl/proclet.ipp"
+#include "nu/proclet_stream.hpp"
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "nu/proclet.hpp"
+#include "nu/utils/cond_var.hpp"
+#include "nu/utils/future.hpp"
+#include "nu/utils/mutex.hpp"
+
+namespace nu {
+
+// Coalesces the calls that concurrent threads issue to the same proclet.
+// While a batch is in flight, newly issued calls queue up and then get shipped
+// together as a single proclet call, which runs them back to back within one
+// thread of the proclet and returns all their results at once. Only pays off
+// for calls whose execution time is small compared with an RPC.
+template <typename T>
+class ProcletCombiner {
+ public:
+  constexpr static uint32_t kMaxBatchSize = 64;
+
+  ProcletCombiner(WeakProclet<T> proclet);
+  ProcletCombiner(const ProcletCombiner &) = delete;
+  ProcletCombiner &operator=(const ProcletCombiner &) = delete;
+  template <typename RetT, typename... S0s, typename... S1s>
+  Future<RetT> run_async(RetT (*fn)(T &, S0s...), S1s &&...states)
+    requires ValidInvocationTypes<RetT, S0s...>;
+  template <typename RetT, typename... S0s, typename... S1s>
+  RetT run(RetT (*fn)(T &, S0s...), S1s &&...states)
+    requires ValidInvocationTypes<RetT, S0s...>;
+  template <typename RetT, typename... A0s, typename... A1s>
+  Future<RetT> run_async(RetT (T::*md)(A0s...), A1s &&...args)
+    requires ValidInvocationTypes<RetT, A0s...>;
+  template <typename RetT, typename... A0s, typename... A1s>
+  RetT run(RetT (T::*md)(A0s...), A1s &&...args)
+    requires ValidInvocationTypes<RetT, A0s...>;
+
+ private:
+  using Invoker = std::string (*)(T &, const std::string &);
+
+  struct Call {
+    uintptr_t invoker_addr;
+    std::string args;
+    std::string ret;
+    bool done = false;
+  };
+
+  WeakProclet<T> proclet_;
+  std::vector<Call *> pending_;
+  bool in_flight_;
+  Mutex mutex_;
+  CondVar cond_var_;
+
+  template <typename RetT, typename... S0s>
+  static std::string invoke(T &t, const std::string &args);
+  void combine(Call *call);
+};
+
+}  // namespace nu
+
+#include "nu/impl/proclet_combiner.ipp"
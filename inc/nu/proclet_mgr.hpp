@@ -7,6 +7,10 @@
 #include <list>
 #include <memory>
 #include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 extern "C" {
@@ -17,9 +21,11 @@ extern "C" {
 
 #include "nu/commons.hpp"
 #include "nu/utils/blocked_syncer.hpp"
+#include "nu/utils/caller_tracker.hpp"
 #include "nu/utils/cond_var.hpp"
 #include "nu/utils/counter.hpp"
 #include "nu/utils/cpu_load.hpp"
+#include "nu/utils/dirty_page_tracker.hpp"
 #include "nu/utils/mutex.hpp"
 #include "nu/utils/rcu_lock.hpp"
 #include "nu/utils/slab.hpp"
@@ -28,12 +34,15 @@ extern "C" {
 
 namespace nu {
 
+class InvocationStats;
+
 enum ProcletStatus {
   kAbsent = 0,
   kPopulating,
   kDepopulating,
   kCleaning,
   kMigrating,
+  kSpilled,
   kPresent,
   kDestructing,
 };
@@ -42,6 +51,8 @@ enum ProcletStatus {
 // even if the proclets are not present locally.
 extern uint8_t proclet_statuses[kMaxNumProclets];
 extern SpinLock proclet_migration_spin[kMaxNumProclets];
+// Where the proclets went when they were last migrated out of this node.
+extern ProcletLocation proclet_forward_locations[kMaxNumProclets];
 
 struct ProcletHeader {
   ~ProcletHeader() = default;
@@ -49,6 +60,9 @@ struct ProcletHeader {
   // Used for monitoring cpu load.
   CPULoad cpu_load;
 
+  // High-priority calls served since the pressure handler last looked.
+  std::atomic<uint32_t> num_high_priority_calls;
+
   // Max heap size.
   uint64_t populate_size;
   uint64_t capacity;
@@ -60,6 +74,11 @@ struct ProcletHeader {
   // Migration related.
   std::atomic<int8_t> pending_load_cnt;
   bool migratable;
+  // Bumped on every setup, for telling apart proclets reusing the segment.
+  uint32_t generation;
+  // Threads pre-faulting the heap for an incoming migration. Never copied nor
+  // constructed, as it is back to zero whenever the segment changes hands.
+  std::atomic<uint8_t> num_populators;
 
   //--- Fields below will be automatically copied during migration. ---/
   uint8_t copy_start[0];
@@ -82,6 +101,17 @@ struct ProcletHeader {
   // Ref cnt related.
   int ref_cnt;
 
+  // Remote nodes that recently invoked the proclet.
+  CallerTracker callers;
+
+  // Per-method invocation stats, allocated on the heap once enabled.
+  std::atomic<InvocationStats *> invocation_stats;
+
+  // Location epoch.
+  uint16_t location_epoch;
+  // Assigned by the controller on allocation, tags all location updates.
+  uint32_t location_generation;
+
   // Heap mem allocator. Must be the last field.
   Counter slab_ref_cnt;
   SlabAllocator slab;
@@ -94,23 +124,81 @@ struct ProcletHeader {
   uint8_t status() const;
   bool is_local() const;
   SpinLock &migration_spin();
+  ProcletLocation &forward_location();
   VAddrRange range() const;
 };
 
 class ProcletManager {
  public:
+  // Warm pools of heap segments that are reserved for this node and already
+  // populated, so that creating short-lived proclets locally skips both the
+  // controller and the page faults.
+  constexpr static uint64_t kMaxWarmProcletHeapSize = kDefaultProcletHeapSize;
+  constexpr static uint32_t kWarmHeapPoolSize = 16;
+  constexpr static uint32_t kWarmHeapPoolLowWatermark = 4;
+  constexpr static uint64_t kWarmHeapPopulateSize = 1 << 20;
+  // Heaps that reach this size are backed by transparent huge pages. Smaller
+  // ones stay on base pages, as a huge page would mostly go to waste.
+  constexpr static bool kEnableHugePageHeaps = true;
+  constexpr static uint64_t kHugePageSize = 2 << 20;
+  constexpr static uint64_t kMinHugePageHeapSize = 32 << 20;
+  // A full checkpoint record replaces the deltas once there are this many of
+  // them, or once they add up to more than the heap.
+  constexpr static uint32_t kMaxNumCheckpointDeltas = 16;
+
   ProcletManager();
+  ~ProcletManager();
 
+  // A recycled warm heap keeps its generation and location epoch, so that the
+  // updates of its previous proclet never look newer.
   static void setup(void *proclet_base, uint64_t capacity, bool migratable,
-                    bool from_migration);
-  void cleanup(void *proclet_base, bool for_migration);
+                    bool from_migration, uint32_t location_generation = 0);
+  void cleanup(void *proclet_base, bool for_migration,
+               bool for_recycling = false);
+  // Cleans up a destructed proclet and either recycles its heap segment into
+  // the warm pool or returns it to the controller.
+  void destroy(void *proclet_base);
+  // Only serves creations hinted at this node, so that the controller still
+  // places all the others.
+  std::optional<ProcletAllocation> acquire_warm_heap(uint64_t capacity);
   static void madvise_populate(void *proclet_base, uint64_t populate_len);
+  // Whole segments are covered, so the huge pages stay 2 MiB aligned.
+  static void madvise_huge_pages(void *proclet_base, uint64_t capacity,
+                                 bool enable);
   static void depopulate(void *proclet_base, uint64_t size, bool defer);
   static void wait_until_being_local(ProcletHeader *proclet_header);
+  // Returns once the proclet is not being migrated out or its new location is
+  // known.
+  static void wait_until_handed_off(ProcletHeader *proclet_header);
   void insert(void *proclet_base);
   void undo_remove(void *proclet_base);
   bool remove_for_migration(void *proclet_base);
   bool remove_for_destruction(void *proclet_base);
+  // Spilled proclets have their heaps written to a file under the directory
+  // and released, and are read back on their next invocation. An empty
+  // directory disables spilling.
+  void set_spill_dir(std::string dir);
+  bool can_spill() const;
+  // Fails if the proclet is not present or still has threads, blocked
+  // syncers or timers, or if the file cannot be written.
+  bool spill(void *proclet_base);
+  void reload(void *proclet_base);
+  uint32_t get_num_spilled_proclets();
+  // Checkpoints go to files under the directory, one per proclet, that
+  // survive restarts. An empty directory disables checkpointing.
+  void set_checkpoint_dir(std::string dir);
+  // Snapshots the idle proclets among the given local ones as a consistent
+  // cut and returns how many got checkpointed. Proclets that were also in the
+  // previous checkpoint only have their dirtied pages appended. Pre-copy
+  // migrations fall back to stop-and-copy in between, as the dirty page
+  // tracker is taken.
+  uint32_t checkpoint(std::span<const ProcletID> ids);
+  // Brings the checkpointed proclets back at their original addresses on this
+  // node and returns their ids; see restore_proclet().
+  std::vector<ProcletID> restore_checkpoints();
+  // The ids returned by the last restore_checkpoints(), e.g., the one run on
+  // startup with --restore.
+  const std::vector<ProcletID> &get_restored_ids() const;
   std::vector<void *> get_all_proclets();
   uint64_t get_mem_usage();
   uint32_t get_num_present_proclets();
@@ -121,13 +209,54 @@ class ProcletManager {
       std::function<RetT(const ProcletHeader *)> f);
 
  private:
+  struct WarmHeapPool {
+    std::vector<ProcletAllocation> heaps;
+    bool refilling = false;
+    SpinLock spin;
+  };
+  // Precedes the heap chunks of each full or delta record in a checkpoint.
+  struct CheckpointRecord {
+    uint64_t capacity;
+    int64_t sum_tsc;
+  };
+  struct CheckpointState {
+    uint32_t generation;
+    uint32_t num_deltas;
+    uint64_t delta_bytes;
+  };
+  constexpr static auto kNumWarmHeapPools =
+      bsr_64(kMaxWarmProcletHeapSize) - bsr_64(kMinProcletHeapSize) + 1;
+
+  WarmHeapPool warm_heap_pools_[kNumWarmHeapPools];
   std::vector<void *> present_proclets_;
   std::vector<TimerCallbackArg *> stashed_timer_cbs_;
   uint32_t num_present_proclets_;
   SpinLock spin_;
+  std::string spill_dir_;
+  // Serializes spills, reloads and checkpoints.
+  rt::Mutex spill_mutex_;
+  std::unordered_set<void *> spilled_proclets_;
+  std::string checkpoint_dir_;
+  // Only started while there are proclets to take deltas of.
+  DirtyPageTracker checkpoint_tracker_;
+  bool checkpoint_tracking_;
+  // The proclets in the last checkpoint.
+  std::unordered_map<ProcletHeader *, CheckpointState> checkpoint_states_;
+  std::vector<ProcletID> restored_ids_;
   friend class Test;
 
   bool __remove(void *proclet_base, ProcletStatus new_status);
+  bool pause_if_idle(ProcletHeader *proclet_header);
+  void restore_spilled(void *proclet_base);
+  std::string get_spill_path(void *proclet_base) const;
+  bool write_spill_file(ProcletHeader *proclet_header, VAddrRange range);
+  void read_spill_file(ProcletHeader *proclet_header);
+  std::string get_checkpoint_path(ProcletID id) const;
+  bool write_checkpoint_file(ProcletHeader *proclet_header, bool incremental,
+                             CheckpointState *state);
+  bool restore_checkpoint(ProcletID id);
+  WarmHeapPool &get_warm_heap_pool(uint64_t capacity);
+  void refill_warm_heap_pool(uint64_t capacity);
 };
 
 }  // namespace nu
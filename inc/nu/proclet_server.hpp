@@ -34,9 +34,12 @@ class ProcletServer {
   static void construct_proclet(ArchivePool<>::IASStream *ia_sstream,
                                 RPCReturner *returner);
   template <typename Cls, typename... As>
+  static void construct_proclets(ArchivePool<>::IASStream *ia_sstream,
+                                 RPCReturner *returner);
+  template <typename Cls, typename... As>
   static void construct_proclet_locally(MigrationGuard &&caller_guard,
                                         void *base, uint64_t size, bool pinned,
-                                        As &&...args);
+                                        uint32_t generation, As &&...args);
   template <bool MigrEn, bool CPUMon, bool CPUSamp, typename Cls, typename RetT,
             typename FnPtr, typename... S1s>
   static void run_closure(ArchivePool<>::IASStream *ia_sstream,
@@ -68,6 +71,9 @@ class ProcletServer {
   static void __construct_proclet(MigrationGuard *callee_guard, Cls *obj,
                                   ArchivePool<>::IASStream *ia_sstream,
                                   RPCReturner returner);
+  template <typename Cls, typename... As>
+  static void __construct_root_obj(MigrationGuard *callee_guard, Cls *obj,
+                                   ArchivePool<>::IASStream *ia_sstream);
   template <typename Cls>
   static void __update_ref_cnt(MigrationGuard *callee_guard, Cls *obj,
                                ArchivePool<>::IASStream *ia_sstream,
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+
+#include "nu/proclet.hpp"
+#include "nu/utils/cond_var.hpp"
+#include "nu/utils/future.hpp"
+#include "nu/utils/mutex.hpp"
+
+namespace nu {
+
+// An ordered call channel to a proclet. Calls issued through a stream are
+// pipelined on the wire but executed by the proclet one at a time in issuing
+// order, regardless of migrations. A stream must not be used by multiple
+// threads concurrently, and must not outlive its proclet. Destroying or
+// overwriting a stream never blocks: its state gets released in the
+// background once the previously issued calls finish.
+template <typename T>
+class ProcletStream {
+ public:
+  ProcletStream();
+  ProcletStream(const ProcletStream &) = delete;
+  ProcletStream &operator=(const ProcletStream &) = delete;
+  ProcletStream(ProcletStream &&);
+  ProcletStream &operator=(ProcletStream &&);
+  ~ProcletStream();
+  operator bool() const;
+  template <typename RetT, typename... S0s, typename... S1s>
+  Future<RetT> run_async(RetT (*fn)(T &, S0s...), S1s &&...states)
+    requires ValidInvocationTypes<RetT, S0s...>;
+  template <typename RetT, typename... S0s, typename... S1s>
+  RetT run(RetT (*fn)(T &, S0s...), S1s &&...states)
+    requires ValidInvocationTypes<RetT, S0s...>;
+  template <typename RetT, typename... A0s, typename... A1s>
+  Future<RetT> run_async(RetT (T::*md)(A0s...), A1s &&...args)
+    requires ValidInvocationTypes<RetT, A0s...>;
+  template <typename RetT, typename... A0s, typename... A1s>
+  RetT run(RetT (T::*md)(A0s...), A1s &&...args)
+    requires ValidInvocationTypes<RetT, A0s...>;
+  // Waits for all issued calls to finish and releases the stream.
+  void reset();
+
+ private:
+  // Lives inside the heap of the target proclet so that it gets migrated
+  // together with the blocked calls.
+  struct State {
+    Mutex mutex;
+    uint64_t next_seq = 0;
+    // The calls that arrived ahead of their turn, keyed by sequence number,
+    // so that each completion wakes up only the next call.
+    std::unordered_map<uint64_t, CondVar *> waiters;
+
+    void wait_for_turn(uint64_t seq);
+    void finish_turn();
+  };
+
+  WeakProclet<T> proclet_;
+  uintptr_t state_addr_;
+  uint64_t next_seq_;
+  friend class Proclet<T>;
+
+  ProcletStream(WeakProclet<T> proclet);
+  Future<void> release_async();
+};
+
+}  // namespace nu
+
+#include "nu/impl/proclet_stream.ipp"
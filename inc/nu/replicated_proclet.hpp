@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "nu/commons.hpp"
+#include "nu/proclet.hpp"
+#include "nu/utils/mutex.hpp"
+#include "nu/utils/read_skewed_lock.hpp"
+
+namespace nu {
+
+// A proclet whose root object is replicated onto multiple nodes for serving
+// read-mostly state. Reads (functions taking a const T & and const methods)
+// are served by a local replica when there is one, or by the primary
+// otherwise. Writes go to the primary, which applies them to every replica
+// in order before returning, so writes must be deterministic. Replicas are
+// ordinary proclets and hence get migrated by the pressure handler. The
+// pressure handler does not create or retire replicas though: it cannot park,
+// while changing the replica set takes RPCs to the primary. The replica count
+// is set at creation and adjusted through add_replica()/retire_replica().
+template <typename T>
+class ReplicatedProclet {
+ public:
+  ReplicatedProclet() = default;
+  ReplicatedProclet(const ReplicatedProclet &) = default;
+  ReplicatedProclet &operator=(const ReplicatedProclet &) = default;
+  ReplicatedProclet(ReplicatedProclet &&) = default;
+  ReplicatedProclet &operator=(ReplicatedProclet &&) = default;
+  operator bool() const;
+  template <typename RetT, typename... S0s, typename... S1s>
+  RetT run(RetT (*fn)(const T &, S0s...), S1s &&...states)
+    requires ValidInvocationTypes<RetT, S0s...>;
+  template <typename RetT, typename... S0s, typename... S1s>
+  RetT run(RetT (*fn)(T &, S0s...), S1s &&...states)
+    requires ValidInvocationTypes<RetT, S0s...>;
+  template <typename RetT, typename... A0s, typename... A1s>
+  RetT run(RetT (T::*md)(A0s...) const, A1s &&...args)
+    requires ValidInvocationTypes<RetT, A0s...>;
+  template <typename RetT, typename... A0s, typename... A1s>
+  RetT run(RetT (T::*md)(A0s...), A1s &&...args)
+    requires ValidInvocationTypes<RetT, A0s...>;
+  void add_replica(std::optional<NodeIP> ip_hint = std::nullopt);
+  void retire_replica();
+  uint32_t num_replicas() const;
+  // Picks up the replicas added or retired through other handles.
+  void refresh();
+
+  template <class Archive>
+  void serialize(Archive &ar);
+
+ private:
+  // Reads run concurrently with the writes that the primary pushes, so obj
+  // and retired are only accessed under lock.
+  struct Replica {
+    T obj;
+    bool retired;
+    ReadSkewedLock lock;
+
+    Replica(T t);
+  };
+
+  struct Primary {
+    T obj;
+    std::optional<uint64_t> capacity;
+    std::vector<Proclet<Replica>> replicas;
+    // Serializes writes and changes to the replica set.
+    Mutex mutex;
+    // Keeps reads off obj while a write applies to it.
+    ReadSkewedLock lock;
+
+    template <typename... As>
+    Primary(std::optional<uint64_t> capacity, As &&...args);
+    template <typename RetT, typename... S0s>
+    RetT write(uintptr_t fn_addr, S0s... states);
+  };
+
+  Proclet<Primary> primary_;
+  std::vector<Proclet<Replica>> replicas_;
+
+  template <typename RetT, typename... S0s, typename... S1s>
+  RetT read(uintptr_t fn_addr, S1s &&...states);
+  template <typename U, typename... As>
+  friend ReplicatedProclet<U> make_replicated_proclet(
+      std::tuple<As...>, std::optional<uint32_t>, std::optional<uint64_t>);
+};
+
+// Places the primary and num_replicas replicas onto distinct nodes, by
+// default one replica per node other than the primary's.
+template <typename T, typename... As>
+ReplicatedProclet<T> make_replicated_proclet(
+    std::tuple<As...> args_tuple,
+    std::optional<uint32_t> num_replicas = std::nullopt,
+    std::optional<uint64_t> capacity = std::nullopt);
+
+}  // namespace nu
+
+#include "nu/impl/replicated_proclet.ipp"
@@ -2,11 +2,13 @@
 
 #include <sync.h>
 
+#include <atomic>
 #include <limits>
 #include <memory>
 #include <unordered_map>
 #include <utility>
 
+#include "nu/rpc_server.hpp"
 #include "nu/runtime_alloc.hpp"
 #include "nu/utils/rcu_hash_map.hpp"
 #include "nu/utils/rpc.hpp"
@@ -15,6 +17,12 @@ namespace nu {
 
 using NodeID = uint16_t;
 
+struct RPCReqUpdateCache {
+  RPCReqType rpc_type = kUpdateCache;
+  ProcletID id;
+  uint64_t location_raw;  // ProcletLocation is non-POD, so it cannot be packed.
+} __attribute__((packed));
+
 class RPCClientMgr {
  public:
   RPCClientMgr(uint16_t port);
@@ -23,13 +31,18 @@ class RPCClientMgr {
   NodeIP get_ip_by_proclet_id(ProcletID proclet_id);
   void remove_by_ip(NodeIP ip);
   void update_cache(ProcletID proclet_id, NodeIP ip);
-  void invalidate_cache(ProcletID proclet_id, RPCClient *old_client);
+  void update_cache(ProcletID proclet_id, ProcletLocation location);
+  void invalidate_cache(ProcletID proclet_id, RPCClient *old_client,
+                        const RPCReturnBuffer &wrong_client_resp);
+  // Lookups that had to go through the controller so far.
+  uint64_t get_num_resolves() const;
 
  private:
   union NodeInfo {  // Supports atomic assignment.
     struct {
       NodeIP ip;
       NodeID id;
+      uint16_t epoch;
     };
     uint64_t raw = 0;
 
@@ -45,6 +58,7 @@ class RPCClientMgr {
   rt::Mutex node_info_mutexes_[get_max_slab_id() + 1];
   std::unordered_map<NodeIP, NodeID> node_ip_to_node_id_map_;
   NodeID next_node_id_;
+  std::atomic<uint64_t> num_resolves_;
   std::unique_ptr<RPCClient>
       rpc_clients_[std::numeric_limits<NodeID>::max() + 1];
   rt::Mutex mutex_;
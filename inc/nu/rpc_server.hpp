@@ -16,17 +16,20 @@ enum RPCReqEnum {
   // Controller
   kRegisterNode,
   kAllocateProclet,
+  kAllocateProclets,
+  kClaimProclet,
   kDestroyProclet,
   kResolveProclet,
   kAcquireMigrationDest,
   kAcquireNode,
   kReleaseNode,
-  kUpdateLocation,
+  kUpdateLocations,
   kReportFreeResource,
   kDestroyLP,
   // Proclet server,
   kProcletCall,
   kGCStack,
+  kUpdateCache,
   kShutdown
 };
 
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <functional>
 #include <optional>
+#include <string>
 #include <utility>
 
 #include "exception.h"
@@ -35,6 +36,18 @@ class RPCReturner;
 class SlabAllocator;
 class Caladan;
 
+// Applied while the server is being initialized, as the constructor of a
+// non-main server parks for good.
+struct ServerOptions {
+  // Migration bandwidth budget in GB/s, 0 for unlimited.
+  float migration_bw_gbs = 0;
+  std::string migration_trace_path;
+  std::string spill_dir;
+  std::string checkpoint_dir;
+  // Restores the proclets checkpointed under checkpoint_dir.
+  bool restore = false;
+};
+
 struct RPCReqReserveConns {
   RPCReqType rpc_type = kReserveConns;
   uint32_t dest_server_ip;
@@ -67,7 +80,7 @@ class Runtime {
   void init_runtime_heap();
   void init_as_controller();
   void init_as_server(uint32_t remote_ctrl_ip, lpid_t lpid, bool main,
-                      bool isol);
+                      bool isol, const ServerOptions &options);
   template <typename Cls, typename... A0s, typename... A1s>
   bool run_within_proclet_env(void *proclet_base, void (*fn)(A0s...),
                               A1s &&...args);
@@ -99,7 +112,7 @@ class Runtime {
   void send_rpc_resp_ok(ArchivePool<>::OASStream *oa_sstream,
                         ArchivePool<>::IASStream *ia_sstream,
                         RPCReturner *returner);
-  void send_rpc_resp_wrong_client(RPCReturner *returner);
+  void send_rpc_resp_wrong_client(ProcletID id, RPCReturner *returner);
   void shutdown(RPCReturner *returner);
 
  private:
@@ -122,7 +135,8 @@ class Runtime {
   friend int ctrl_proxy_main(int, char **);
 
   Runtime();
-  Runtime(uint32_t remote_ctrl_ip, Mode mode, lpid_t lpid, bool isol);
+  Runtime(uint32_t remote_ctrl_ip, Mode mode, lpid_t lpid, bool isol,
+          const ServerOptions &options = ServerOptions());
   template <typename Cls, typename... A0s, typename... A1s>
   bool __run_within_proclet_env(void *proclet_base, void (*fn)(A0s...),
                                 A1s &&...args);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "nu/commons.hpp"
+
+namespace nu {
+
+// Remembers a small set of remote nodes that recently invoked a proclet, so
+// that they can be told about its new location once it gets migrated.
+class CallerTracker {
+ public:
+  constexpr static uint32_t kNumSlots = 8;
+
+  CallerTracker();
+  void record(NodeIP ip);
+  std::vector<NodeIP> get_all() const;
+  void reset();
+
+ private:
+  std::atomic<NodeIP> ips_[kNumSlots];
+  std::atomic<uint32_t> next_slot_;
+};
+
+}  // namespace nu
+
+#include "nu/impl/caller_tracker.ipp"
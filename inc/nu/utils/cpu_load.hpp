@@ -17,6 +17,7 @@ class CPULoad {
   bool is_monitoring() const;
   float get_load() const;
   float get_avg_load() const;
+  uint64_t get_num_invocations() const;
   void zero();
   void halve();
   void twice();
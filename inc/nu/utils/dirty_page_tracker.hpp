@@ -0,0 +1,39 @@
+#pragma once
+
+#include <sync.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "nu/commons.hpp"
+
+namespace nu {
+
+// Tracks the pages written since start() through the kernel's soft-dirty bits.
+// The bits are only cleared by start(), so the dirty set grows monotonically
+// and never misses a write racing with a scan. The bits are process-wide,
+// hence at most one tracker can be started at a time.
+class DirtyPageTracker {
+ public:
+  DirtyPageTracker();
+  ~DirtyPageTracker();
+  // Returns false if soft-dirty tracking is unavailable or another tracker is
+  // running.
+  bool start();
+  // Appends the page-aligned ranges within [start, end) that have been
+  // written since start(), merging adjacent pages.
+  void get_dirty_ranges(uint64_t start, uint64_t end,
+                        std::vector<VAddrRange> *ranges);
+  void stop();
+
+ private:
+  constexpr static uint64_t kSoftDirtyBit = 1ULL << 55;
+  // Kept small, as the buffer lives on the (uthread) stack.
+  constexpr static uint32_t kNumEntriesPerRead = 256;
+
+  int pagemap_fd_;
+  bool started_;
+  static rt::Mutex mutex_;
+};
+
+}  // namespace nu
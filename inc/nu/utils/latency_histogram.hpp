@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace nu {
+
+// A concurrent, log-bucketed latency histogram. Bucket i counts the samples
+// within [2^i, 2^(i+1)) ns; bucket 0 also takes 0 ns and the last bucket takes
+// everything beyond.
+class LatencyHistogram {
+ public:
+  constexpr static uint32_t kNumBuckets = 32;
+
+  struct Snapshot {
+    std::array<uint64_t, kNumBuckets> buckets;
+    uint64_t count;
+    uint64_t sum_ns;
+
+    uint64_t mean_ns() const;
+    // Returns the upper bound of the bucket that holds the p-th percentile.
+    uint64_t percentile_ns(double p) const;
+  };
+
+  LatencyHistogram();
+  void add(uint64_t duration_tsc);
+  void add_ns(uint64_t duration_ns);
+  Snapshot snapshot() const;
+  void reset();
+
+ private:
+  std::atomic<uint64_t> buckets_[kNumBuckets];
+  std::atomic<uint64_t> sum_ns_;
+};
+
+}  // namespace nu
+
+#include "nu/impl/latency_histogram.ipp"
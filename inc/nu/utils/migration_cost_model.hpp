@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+#include "nu/commons.hpp"
+#include "nu/utils/spin_lock.hpp"
+
+namespace nu {
+
+// Models the time it takes to migrate a proclet as a fixed overhead plus its
+// size over the throughput. Both are fitted online by least squares over the
+// observed migrations, with exponential decay, per destination and across
+// all of them. Falls back to the defaults until enough samples are in.
+class MigrationCostModel {
+ public:
+  constexpr static float kDefaultFixedCostUs = 25;
+  constexpr static float kDefaultNetBwGbps = 100;
+  // Weight kept by the past samples on every new one.
+  constexpr static double kDecay = 0.98;
+  constexpr static double kMinNumSamples = 8;
+
+  struct Params {
+    float fixed_cost_us;
+    float bytes_per_us;
+
+    float estimate_us(uint64_t bytes) const;
+    float get_bw_gbps() const;
+  };
+
+  MigrationCostModel();
+  void add_sample(NodeIP dest_ip, uint64_t bytes, uint64_t duration_us);
+  // Across all destinations, for when the destination is not known yet.
+  Params get_params();
+  Params get_params(NodeIP dest_ip);
+
+ private:
+  struct Fit {
+    double n = 0;
+    double sum_x = 0;
+    double sum_y = 0;
+    double sum_xx = 0;
+    double sum_xy = 0;
+
+    void add(double x, double y);
+    std::optional<Params> solve() const;
+  };
+
+  SpinLock spin_;
+  Fit all_fit_;
+  std::unordered_map<NodeIP, Fit> dest_fits_;
+  Params default_params_;
+};
+
+}  // namespace nu
+
+#include "nu/impl/migration_cost_model.ipp"
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <sync.h>
+
+#include <boost/circular_buffer.hpp>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "nu/commons.hpp"
+
+namespace nu {
+
+struct MigrationSpan {
+  enum Phase : uint8_t {
+    // Source.
+    kPickTasks,
+    kAcquireNode,
+    kApprovalWait,
+    kPreCopy,
+    kPause,
+    kTransmitHeap,
+    kTransmitMutexes,
+    kTransmitCondVars,
+    kTransmitThreads,
+    kTransmitTime,
+    kUpdateLocation,
+    kCleanup,
+    // Destination.
+    kPopulate,
+    kLoadHeap,
+    kLoadMutexes,
+    kLoadCondVars,
+    kLoadThreads,
+    kLoadTime,
+    kNumPhases
+  };
+
+  Phase phase;
+  // 0 for the migrating thread itself, i + 1 for the i-th aux handler.
+  uint32_t lane;
+  // 0 if the span is not specific to a proclet.
+  ProcletID proclet_id;
+  uint64_t start_tsc;
+  uint64_t end_tsc;
+};
+
+struct MigrationRecord {
+  uint64_t seq;
+  bool is_source;
+  NodeIP peer_ip;
+  uint32_t num_proclets;
+  uint64_t start_us;
+  uint64_t start_tsc;
+  uint64_t end_tsc;
+  std::vector<MigrationSpan> spans;
+
+  void add(MigrationSpan::Phase phase, uint64_t start_tsc, uint64_t end_tsc,
+           ProcletID proclet_id = 0, uint32_t lane = 0);
+};
+
+// Times the enclosing scope as one span of a record, if there is one.
+class MigrationSpanGuard {
+ public:
+  MigrationSpanGuard(MigrationRecord *record, MigrationSpan::Phase phase,
+                     ProcletID proclet_id = 0);
+  ~MigrationSpanGuard();
+
+ private:
+  MigrationRecord *record_;
+  MigrationSpan::Phase phase_;
+  ProcletID proclet_id_;
+  uint64_t start_tsc_;
+};
+
+// Keeps the phase timings of the recent migrations of this node. Records are
+// filled by the migrating thread alone, and only handed to the tracer once
+// complete. Until enabled, no record gets started, so that migrations pay
+// nothing for tracing.
+class MigrationTracer {
+ public:
+  constexpr static uint32_t kMaxNumRecords = 4096;
+  constexpr static uint32_t kMaxNumPrologueSpans = 64;
+
+  MigrationTracer();
+  void enable();
+  bool is_enabled() const;
+  // Returns nullptr if not enabled.
+  std::unique_ptr<MigrationRecord> start_record(bool is_source,
+                                                NodeIP peer_ip);
+  void finish_record(std::unique_ptr<MigrationRecord> record);
+  uint64_t get_num_finished_records() const;
+  // Spans that precede the next source record, e.g., picking its tasks.
+  void add_prologue(MigrationSpan::Phase phase, uint64_t start_tsc,
+                    uint64_t end_tsc);
+  // One line per record, with the per-phase totals in us.
+  void write_records(std::ostream &os);
+  // In the Chrome trace event format (chrome://tracing, Perfetto).
+  void write_chrome_trace(std::ostream &os);
+  static const char *phase_name(MigrationSpan::Phase phase);
+
+ private:
+  bool enabled_;
+  rt::Spin spin_;
+  uint64_t next_seq_;
+  uint64_t num_finished_records_;
+  std::vector<MigrationSpan> prologue_;
+  boost::circular_buffer<std::unique_ptr<MigrationRecord>> records_;
+};
+
+}  // namespace nu
+
+#include "nu/impl/migration_tracer.ipp"
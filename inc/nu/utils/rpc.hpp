@@ -6,6 +6,7 @@
 
 #include <climits>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <queue>
@@ -75,16 +76,30 @@ class RPCReturnBuffer {
 
 enum RPCReturnCode { kErrWrongClient = -2, kErrTimeout = -1, kOk = 0 };
 
+// Higher-priority requests jump ahead in the send queues and the server's run
+// queue. Calls to local proclets run inline in the caller's thread, so there
+// is no queue to reorder and their priority is ignored.
+enum RPCPriority : uint8_t {
+  kLowPriority = 0,
+  kNormalPriority,
+  kHighPriority,
+  kNumRPCPriorities
+};
+
 class RPCReturner {
  public:
   RPCReturner() {}
-  RPCReturner(void *rpc_server, std::size_t completion_data);
+  RPCReturner(void *rpc_server, std::size_t completion_data,
+              RPCPriority priority = kNormalPriority, uint64_t recv_tsc = 0);
   void Return(RPCReturnCode rc, std::span<const std::byte> buf,
               std::move_only_function<void()> deleter_fn = nullptr);
   void Return(RPCReturnCode rc);
   
   netaddr local_addr;
   netaddr remote_addr;
+  RPCPriority priority = kNormalPriority;
+  // When the request was received, used for measuring queueing delay.
+  uint64_t recv_tsc = 0;
 
   ConnAddrPair GetRPCAddrPair();
   netaddr GetLocalAddr();
@@ -122,7 +137,7 @@ class RPCCompletion {
 
   // Complete the request by invoking the callback and waking up the blocking
   // thread.
-  void Done(ssize_t len, rt::TcpConn *c);
+  void Done(RPCReturnCode rc, std::size_t len, rt::TcpConn *c);
 
   RPCReturnCode get_return_code() const {
     Poll();
@@ -158,7 +173,8 @@ class RPCFlow {
   static std::unique_ptr<RPCFlow> New(unsigned int cpu_affinity, netaddr raddr);
 
   // Make an RPC call over this flow.
-  void Call(std::span<const std::byte> src, RPCCompletion *c);
+  void Call(std::span<const std::byte> src, RPCCompletion *c,
+            RPCPriority priority);
 
   // Disable move and copy.
   RPCFlow(const RPCFlow &) = delete;
@@ -169,6 +185,7 @@ class RPCFlow {
   struct req_ctx {
     std::span<const std::byte> payload;
     RPCCompletion *completion;
+    RPCPriority priority;
   };
 
   // Internal worker threads for sending and receiving.
@@ -184,7 +201,9 @@ class RPCFlow {
   unsigned int sent_count_;
   unsigned int recv_count_;
   unsigned int credits_;
-  std::queue<req_ctx> reqs_;
+  // One queue per priority.
+  std::queue<req_ctx> reqs_[kNumRPCPriorities];
+  uint32_t num_queued_reqs_ = 0;
   uint64_t last_sent_us_;
 };
 
@@ -199,11 +218,13 @@ class RPCClient {
 
   // Calls an RPC method, the RPC layer allocates a return buffer and stores
   // response into it.
-  RPCReturnCode Call(std::span<const std::byte> args, RPCReturnBuffer *buf);
+  RPCReturnCode Call(std::span<const std::byte> args, RPCReturnBuffer *buf,
+                     RPCPriority priority = kNormalPriority);
 
   // Calls an RPC method, the RPC layer invokes the callback when the response
   // is ready on the TCP connection.
-  RPCReturnCode Call(std::span<const std::byte> args, RPCCallback &&callback);
+  RPCReturnCode Call(std::span<const std::byte> args, RPCCallback &&callback,
+                     RPCPriority priority = kNormalPriority);
 
   netaddr GetAddr() { return raddr_; }
 
@@ -7,6 +7,7 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <vector>
 
 #include "nu/commons.hpp"
 #include "nu/utils/caladan.hpp"
@@ -49,6 +50,10 @@ class SlabAllocator {
   static void *reallocate(const void *ptr, size_t size);
   static void register_slab_by_id(SlabAllocator *slab, SlabId_t slab_id);
   static void deregister_slab_by_id(SlabId_t slab_id);
+  // Returns the sorted, page-aligned ranges of at least min_len bytes that
+  // lie within free blocks and hold no allocator metadata. Must be called
+  // when no one else is using the slab.
+  std::vector<VAddrRange> get_free_regions(uint64_t min_len);
 
  private:
   class FreePtrsLinkedList {
@@ -57,14 +62,17 @@ class SlabAllocator {
     void *pop();
     uint64_t size();
     void splice(FreePtrsLinkedList &o);
+    template <typename F>
+    void for_each(F &&f);
 
-   private:
     constexpr static uint32_t kBatchSize =
         ((1 << kMinSlabClassShift) + sizeof(PtrHeader)) / sizeof(void *);
     struct Batch {
       void *p[kBatchSize];
     };
 
+   private:
+
     Batch *head_ = nullptr;
     Batch *tail_ = nullptr;
     uint64_t size_ = 0;
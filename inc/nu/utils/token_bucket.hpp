@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include "nu/utils/spin_lock.hpp"
+
+namespace nu {
+
+// A thread-safe token bucket over bytes. Consumers that overdraw the bucket
+// wait until the tokens they took have been refilled, so concurrent consumers
+// share the rate. They park if they can, and spin otherwise.
+class TokenBucket {
+ public:
+  // A rate of 0 means unlimited.
+  TokenBucket(uint64_t rate_bytes_per_s = 0, uint64_t burst_bytes = 0);
+  void set_rate(uint64_t rate_bytes_per_s);
+  uint64_t get_rate() const;
+  void consume(uint64_t bytes);
+
+ private:
+  SpinLock spin_;
+  uint64_t rate_;
+  uint64_t burst_;
+  double tokens_;
+  uint64_t last_refill_us_;
+
+  void refill(uint64_t now_us);
+};
+
+}  // namespace nu
+
+#include "nu/impl/token_bucket.ipp"
@@ -82,6 +82,11 @@ NuOptionsDesc::NuOptionsDesc(bool help) : OptionsDesc("Nu arguments", help) {
     ("nomemps", "don't react to memory pressure")
     ("nocpups", "don't react to CPU pressure")
     ("isol", "as an isolated node")
+    ("migration_bw", boost::program_options::value(&migration_bw_gbs)->default_value(0), "migration bandwidth budget in GB/s (0 for unlimited)")
+    ("migration_trace", boost::program_options::value(&migration_trace_path)->default_value(""), "dump per-migration phase timings to <path>.txt and <path>.json periodically and on exit")
+    ("spill_dir", boost::program_options::value(&spill_dir)->default_value(""), "spill cold proclets to files under <dir> when no node can take them")
+    ("checkpoint_dir", boost::program_options::value(&checkpoint_dir)->default_value(""), "checkpoint proclets to files under <dir>")
+    ("restore", "restore the proclets checkpointed under --checkpoint_dir on startup")
 #ifdef DDB_SUPPORT
     ("ddb", "enable DDB")
     ("ddb_addr", boost::program_options::value(&ddb_addr)->default_value("10.10.1.1"), "ddb ip capture at runtime initialization")
@@ -1,6 +1,8 @@
 #include <cereal/archives/binary.hpp>
 #include <cstdint>
 #include <limits>
+#include <optional>
+#include <vector>
 
 extern "C" {
 #include <base/assert.h>
@@ -31,7 +33,7 @@ constexpr NodeIP get_proclet_segment_bucket_id(uint64_t capacity) {
 
 LPInfo::LPInfo() : rr_iter(node_statuses.end()), destroying(false) {}
 
-Controller::Controller() {
+Controller::Controller() : next_generation_(1) {
   for (lpid_t lpid = 1; lpid < std::numeric_limits<lpid_t>::max(); lpid++) {
     free_lpids_.insert(lpid);
   }
@@ -129,7 +131,10 @@ std::optional<std::pair<lpid_t, VAddrRange>> Controller::register_node(
   }
 
   if (main) {
-    auto [_, success] = proclet_id_to_ip_.emplace(kMainProcletHeapVAddr, ip);
+    ProcletRecord record{.generation = 0};
+    record.location.ip = ip;
+    auto [_, success] =
+        proclet_id_to_record_.emplace(kMainProcletHeapVAddr, record);
     if (!success) {
       return std::nullopt;
     }
@@ -183,10 +188,36 @@ void Controller::destroy_lp(lpid_t lpid, NodeIP requestor_ip) {
   }
 }
 
-std::optional<std::pair<ProcletID, NodeIP>> Controller::allocate_proclet(
+std::optional<ProcletAllocation> Controller::allocate_proclet(
     uint64_t capacity, lpid_t lpid, NodeIP ip_hint) {
   ScopedLock lock(&mutex_);
 
+  return __allocate_proclet(capacity, lpid, ip_hint);
+}
+
+std::vector<ProcletAllocation> Controller::allocate_proclets(
+    uint64_t capacity, lpid_t lpid, NodeIP ip_hint, uint32_t num) {
+  ScopedLock lock(&mutex_);
+
+  std::vector<ProcletAllocation> allocated;
+  allocated.reserve(num);
+  for (uint32_t i = 0; i < num; i++) {
+    auto optional = __allocate_proclet(capacity, lpid, ip_hint);
+    if (unlikely(!optional)) {
+      // All or nothing.
+      for (auto &[id, _0, _1] : allocated) {
+        __destroy_proclet(VAddrRange{.start = id, .end = id + capacity});
+      }
+      allocated.clear();
+      break;
+    }
+    allocated.emplace_back(*optional);
+  }
+  return allocated;
+}
+
+std::optional<ProcletAllocation> Controller::__allocate_proclet(
+    uint64_t capacity, lpid_t lpid, NodeIP ip_hint) {
   auto &bucket =
       free_proclet_heap_segments_[get_proclet_segment_bucket_id(capacity)];
   if (unlikely(bucket.empty())) {
@@ -212,32 +243,106 @@ std::optional<std::pair<ProcletID, NodeIP>> Controller::allocate_proclet(
   if (unlikely(!node_ip)) {
     return std::nullopt;
   }
-  auto [iter, _] = proclet_id_to_ip_.try_emplace(id);
-  iter->second = node_ip;
-  return std::make_pair(id, node_ip);
+  // The epoch stays unknown until the first migration gets published.
+  ProcletRecord record{.generation = next_generation_++};
+  record.location.ip = node_ip;
+  proclet_id_to_record_[id] = record;
+  return ProcletAllocation{
+      .id = id, .ip = node_ip, .generation = record.generation};
+}
+
+// Pops the segment starting at start_addr out of the stack, if there is one.
+static std::optional<ProcletHeapSegment> take_segment(
+    std::stack<ProcletHeapSegment> *segments, uint64_t start_addr) {
+  std::vector<ProcletHeapSegment> others;
+  std::optional<ProcletHeapSegment> taken;
+  while (!segments->empty()) {
+    auto segment = segments->top();
+    segments->pop();
+    if (segment.range.start == start_addr) {
+      taken = segment;
+      break;
+    }
+    others.push_back(segment);
+  }
+  for (auto iter = others.rbegin(); iter != others.rend(); ++iter) {
+    segments->push(*iter);
+  }
+  return taken;
+}
+
+std::optional<uint32_t> Controller::claim_proclet(ProcletID id,
+                                                 uint64_t capacity,
+                                                 lpid_t lpid, NodeIP ip) {
+  ScopedLock lock(&mutex_);
+
+  auto info_iter = lpid_to_info_.find(lpid);
+  if (unlikely(info_iter == lpid_to_info_.end() ||
+               !info_iter->second.node_statuses.contains(ip) ||
+               id <= kMainProcletHeapVAddr ||
+               id + capacity > kMaxProcletHeapVAddr ||
+               proclet_id_to_record_.contains(id))) {
+    return std::nullopt;
+  }
+
+  auto bucket_id = get_proclet_segment_bucket_id(capacity);
+  auto &bucket = free_proclet_heap_segments_[bucket_id];
+  if (!take_segment(&bucket, id)) {
+    if (bucket_id == kNumProcletSegmentBuckets - 1) {
+      return std::nullopt;
+    }
+    // Splits the enclosing max-sized segment as __allocate_proclet() does.
+    auto max_start = id - (id - kMinProcletHeapVAddr) % kMaxProcletHeapSize;
+    if ((id - max_start) % capacity) {
+      return std::nullopt;
+    }
+    auto &highest_bucket =
+        free_proclet_heap_segments_[kNumProcletSegmentBuckets - 1];
+    auto max_segment = take_segment(&highest_bucket, max_start);
+    if (!max_segment) {
+      return std::nullopt;
+    }
+    for (auto start_addr = max_segment->range.start;
+         start_addr < max_segment->range.end; start_addr += capacity) {
+      if (start_addr != id) {
+        VAddrRange range = {.start = start_addr,
+                            .end = start_addr + capacity};
+        bucket.push({range, max_segment->prev_host});
+      }
+    }
+  }
+
+  ProcletRecord record{.generation = next_generation_++};
+  record.location.ip = ip;
+  proclet_id_to_record_[id] = record;
+  return record.generation;
 }
 
 void Controller::destroy_proclet(VAddrRange proclet_segment) {
   ScopedLock lock(&mutex_);
 
+  __destroy_proclet(proclet_segment);
+}
+
+void Controller::__destroy_proclet(VAddrRange proclet_segment) {
   auto capacity = proclet_segment.end - proclet_segment.start;
   auto &bucket =
       free_proclet_heap_segments_[get_proclet_segment_bucket_id(capacity)];
   auto proclet_id = proclet_segment.start;
-  auto iter = proclet_id_to_ip_.find(proclet_id);
-  if (unlikely(iter == proclet_id_to_ip_.end())) {
+  auto iter = proclet_id_to_record_.find(proclet_id);
+  if (unlikely(iter == proclet_id_to_record_.end())) {
     WARN();
     return;
   }
-  bucket.push({proclet_segment, iter->second});
-  proclet_id_to_ip_.erase(iter);
+  bucket.push({proclet_segment, iter->second.location.ip});
+  proclet_id_to_record_.erase(iter);
 }
 
 NodeIP Controller::resolve_proclet(ProcletID id) {
   ScopedLock lock(&mutex_);
 
-  auto iter = proclet_id_to_ip_.find(id);
-  return iter != proclet_id_to_ip_.end() ? iter->second : 0;
+  auto iter = proclet_id_to_record_.find(id);
+  return iter != proclet_id_to_record_.end() ? iter->second.location.ip : 0;
 }
 
 NodeIP Controller::select_node_for_proclet(lpid_t lpid, NodeIP ip_hint,
@@ -346,12 +451,25 @@ void Controller::release_node(lpid_t lpid, NodeIP ip) {
   iter->second.cv.signal();
 }
 
-void Controller::update_location(ProcletID id, NodeIP proclet_srv_ip) {
+void Controller::update_locations(
+    std::span<const ProcletLocationUpdate> updates) {
   ScopedLock lock(&mutex_);
 
-  auto iter = proclet_id_to_ip_.find(id);
-  BUG_ON(iter == proclet_id_to_ip_.end());
-  iter->second = proclet_srv_ip;
+  for (auto &update : updates) {
+    // Updates are published asynchronously, so the proclet may have been
+    // destroyed, even replaced by a new one, or migrated again in the
+    // meantime.
+    auto iter = proclet_id_to_record_.find(update.id);
+    if (iter == proclet_id_to_record_.end() ||
+        iter->second.generation != update.generation) {
+      continue;
+    }
+    ProcletLocation location;
+    location.raw = update.location_raw;
+    if (location.is_newer_than(iter->second.location)) {
+      iter->second.location = location;
+    }
+  }
 }
 
 std::vector<std::pair<NodeIP, Resource>> Controller::report_free_resource(
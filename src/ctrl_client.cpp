@@ -50,7 +50,7 @@ std::optional<std::pair<lpid_t, VAddrRange>> ControllerClient::register_node(
   }
 }
 
-std::optional<std::pair<ProcletID, NodeIP>> ControllerClient::allocate_proclet(
+std::optional<ProcletAllocation> ControllerClient::allocate_proclet(
     uint64_t capacity, NodeIP ip_hint) {
   RPCReqAllocateProclet req;
   req.capacity = capacity;
@@ -62,12 +62,42 @@ std::optional<std::pair<ProcletID, NodeIP>> ControllerClient::allocate_proclet(
   if (resp.empty) {
     return std::nullopt;
   } else {
-    auto id = resp.id;
-    auto server_ip = resp.server_ip;
-    return std::make_pair(id, server_ip);
+    return ProcletAllocation{
+        .id = resp.id, .ip = resp.server_ip, .generation = resp.generation};
   }
 }
 
+std::vector<ProcletAllocation> ControllerClient::allocate_proclets(
+    uint64_t capacity, NodeIP ip_hint, uint32_t num) {
+  RPCReqAllocateProclets req;
+  req.capacity = capacity;
+  req.lpid = lpid_;
+  req.ip_hint = ip_hint;
+  req.num = num;
+  RPCReturnBuffer return_buf;
+  BUG_ON(rpc_client_->Call(to_span(req), &return_buf) != kOk);
+  auto buf = return_buf.get_buf();
+  using Entry = ProcletAllocation;
+  auto *begin = reinterpret_cast<const Entry *>(buf.data());
+  return std::vector<Entry>(begin, begin + buf.size() / sizeof(Entry));
+}
+
+std::optional<uint32_t> ControllerClient::claim_proclet(ProcletID id,
+                                                       uint64_t capacity) {
+  RPCReqClaimProclet req;
+  req.id = id;
+  req.capacity = capacity;
+  req.lpid = lpid_;
+  req.ip = get_cfg_ip();
+  RPCReturnBuffer return_buf;
+  BUG_ON(rpc_client_->Call(to_span(req), &return_buf) != kOk);
+  auto &resp = from_span<RPCRespClaimProclet>(return_buf.get_buf());
+  if (!resp.succeed) {
+    return std::nullopt;
+  }
+  return resp.generation;
+}
+
 void ControllerClient::destroy_proclet(VAddrRange heap_segment) {
   RPCReqDestroyProclet req;
   req.heap_segment = heap_segment;
@@ -121,14 +151,18 @@ NodeGuard ControllerClient::acquire_node() {
   return NodeGuard(this, resp.succeed ? req.ip : 0);
 }
 
-void ControllerClient::update_location(ProcletID id, NodeIP proclet_srv_ip) {
+void ControllerClient::update_locations(
+    std::span<const ProcletLocationUpdate> updates) {
   rt::SpinGuard g(&spin_);
 
-  RPCReqUpdateLocation req;
-  req.id = id;
-  req.proclet_srv_ip = proclet_srv_ip;
-  BUG_ON(tcp_conn_->WriteFull(&req, sizeof(req), /* nt = */ false,
-                              /* poll = */ true) != sizeof(req));
+  RPCReqUpdateLocations req;
+  req.num = updates.size();
+  const iovec iovecs[] = {
+      {&req, sizeof(req)},
+      {const_cast<ProcletLocationUpdate *>(updates.data()),
+       updates.size_bytes()}};
+  BUG_ON(tcp_conn_->WritevFull(std::span(iovecs), /* nt = */ false,
+                               /* poll = */ true) < 0);
 }
 
 VAddrRange ControllerClient::get_stack_cluster() const {
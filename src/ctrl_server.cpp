@@ -18,6 +18,7 @@ namespace nu {
 ControllerServer::ControllerServer()
     : num_register_node_(0),
       num_allocate_proclet_(0),
+      num_claim_proclet_(0),
       num_destroy_proclet_(0),
       num_resolve_proclet_(0),
       num_acquire_migration_dest_(0),
@@ -30,14 +31,16 @@ ControllerServer::ControllerServer()
   if constexpr (kEnableLogging) {
     logging_thread_ = rt::Thread([&] {
       std::cout
-          << "time_us register_node allocate_proclet destroy_proclet"
+          << "time_us register_node allocate_proclet claim_proclet "
+             "destroy_proclet"
              "resolve_proclet acquire_migration_dest acquire_node release_node"
              "update_location report_free_resource destroy_ip"
           << std::endl;
       while (!rt::access_once(done_)) {
         timer_sleep(kPrintIntervalUs);
         std::cout << microtime() << " " << num_register_node_ << " "
-                  << num_allocate_proclet_ << " " << num_destroy_proclet_ << " "
+                  << num_allocate_proclet_ << " " << num_claim_proclet_ << " "
+                  << num_destroy_proclet_ << " "
                   << num_resolve_proclet_ << " " << num_acquire_migration_dest_
                   << " " << num_acquire_node_ << " " << num_release_node_ << " "
                   << num_update_location_ << " " << num_report_free_resource_
@@ -101,11 +104,14 @@ void ControllerServer::tcp_loop(rt::TcpConn *c) {
         handle_release_node(req);
         break;
       }
-      case kUpdateLocation: {
-        RPCReqUpdateLocation req;
+      case kUpdateLocations: {
+        RPCReqUpdateLocations req;
         ssize_t data_size = sizeof(req) - sizeof(rpc_type);
         BUG_ON(c->ReadFull(&req.rpc_type + 1, data_size) != data_size);
-        handle_update_location(req);
+        std::vector<ProcletLocationUpdate> updates(req.num);
+        data_size = std::span(updates).size_bytes();
+        BUG_ON(c->ReadFull(updates.data(), data_size) != data_size);
+        handle_update_locations(updates);
         break;
       }
       case kReportFreeResource: {
@@ -160,8 +166,9 @@ ControllerServer::handle_allocate_proclet(const RPCReqAllocateProclet &req) {
   auto optional = ctrl_.allocate_proclet(req.capacity, req.lpid, req.ip_hint);
   if (optional) {
     resp->empty = false;
-    resp->id = optional->first;
-    resp->server_ip = optional->second;
+    resp->id = optional->id;
+    resp->server_ip = optional->ip;
+    resp->generation = optional->generation;
   } else {
     resp->empty = true;
   }
@@ -182,6 +189,43 @@ ControllerServer::handle_allocate_proclet(const RPCReqAllocateProclet &req) {
   return resp;
 }
 
+std::vector<ProcletAllocation>
+ControllerServer::handle_allocate_proclets(const RPCReqAllocateProclets &req) {
+  if constexpr (kEnableLogging) {
+    num_allocate_proclet_ += req.num;
+  }
+
+  auto allocated =
+      ctrl_.allocate_proclets(req.capacity, req.lpid, req.ip_hint, req.num);
+
+  if (kEnableHandlerTrace) {
+    std::osyncstream os(std::cout);
+    os << "allocate_proclets: lpid = " << req.lpid
+        << ", capacity = " << req.capacity
+        << ", ip_hint = " << req.ip_hint
+        << ", num = " << req.num
+        << ", allocated = " << allocated.size()
+        << std::endl;
+    os.emit();
+  }
+
+  return allocated;
+}
+
+std::unique_ptr<RPCRespClaimProclet> ControllerServer::handle_claim_proclet(
+    const RPCReqClaimProclet &req) {
+  if constexpr (kEnableLogging) {
+    num_claim_proclet_++;
+  }
+
+  auto resp = std::make_unique_for_overwrite<RPCRespClaimProclet>();
+  auto generation =
+      ctrl_.claim_proclet(req.id, req.capacity, req.lpid, req.ip);
+  resp->succeed = generation.has_value();
+  resp->generation = generation.value_or(0);
+  return resp;
+}
+
 void ControllerServer::handle_destroy_proclet(const RPCReqDestroyProclet &req) {
   if constexpr (kEnableLogging) {
     num_destroy_proclet_++;
@@ -201,12 +245,13 @@ std::unique_ptr<RPCRespResolveProclet> ControllerServer::handle_resolve_proclet(
   return resp;
 }
 
-void ControllerServer::handle_update_location(const RPCReqUpdateLocation &req) {
+void ControllerServer::handle_update_locations(
+    std::span<const ProcletLocationUpdate> updates) {
   if constexpr (kEnableLogging) {
-    num_update_location_++;
+    num_update_location_ += updates.size();
   }
 
-  ctrl_.update_location(req.id, req.proclet_srv_ip);
+  ctrl_.update_locations(updates);
 }
 
 RPCRespAcquireMigrationDest ControllerServer::handle_acquire_migration_dest(
@@ -1,10 +1,12 @@
 #include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include <algorithm>
 #include <cstddef>
 #include <cstring>
+#include <fstream>
 #include <memory>
 #include <span>
 #include <syncstream>
@@ -25,9 +27,11 @@ extern "C" {
 #include "nu/proclet_mgr.hpp"
 #include "nu/proclet_server.hpp"
 #include "nu/resource_reporter.hpp"
+#include "nu/rpc_client_mgr.hpp"
 #include "nu/runtime.hpp"
 #include "nu/utils/cond_var.hpp"
 #include "nu/utils/mutex.hpp"
+#include "nu/utils/farmhash.hpp"
 #include "nu/utils/scoped_lock.hpp"
 #include "nu/utils/thread.hpp"
 
@@ -103,6 +107,59 @@ void MigratorConnManager::put(uint32_t ip, rt::TcpConn *tcp_conn) {
   pool_map_[ip].push(tcp_conn);
 }
 
+MigrationBatchWriter::MigrationBatchWriter(rt::TcpConn *c) : c_(c) {}
+
+void MigrationBatchWriter::append(const void *buf, size_t len) {
+  size_ += len;
+  if (!iovecs_.empty()) {
+    auto &last = iovecs_.back();
+    if (reinterpret_cast<const uint8_t *>(last.iov_base) + last.iov_len ==
+        buf) {
+      last.iov_len += len;
+      return;
+    }
+  }
+  iovecs_.push_back({const_cast<void *>(buf), len});
+}
+
+void MigrationBatchWriter::write_copy(const void *buf, size_t len) {
+  if (arena_used_ + len > arena_capacity_) {
+    arena_capacity_ = std::max(len, kArenaBlockSize);
+    arena_blocks_.emplace_back(
+        std::make_unique_for_overwrite<uint8_t[]>(arena_capacity_));
+    arena_used_ = 0;
+  }
+  auto *dst = arena_blocks_.back().get() + arena_used_;
+  memcpy(dst, buf, len);
+  arena_used_ += len;
+  append(dst, len);
+}
+
+void MigrationBatchWriter::write_ref(const void *buf, size_t len) {
+  append(buf, len);
+}
+
+ssize_t MigrationBatchWriter::WriteFull(const void *buf, size_t len, bool nt,
+                                        bool poll) {
+  write_copy(buf, len);
+  return len;
+}
+
+netaddr MigrationBatchWriter::RemoteAddr() const { return c_->RemoteAddr(); }
+
+uint64_t MigrationBatchWriter::size() const { return size_; }
+
+void MigrationBatchWriter::flush() {
+  if (!iovecs_.empty()) {
+    get_runtime()->migrator()->transmit_budgeted(c_, iovecs_,
+                                                 /* nt = */ false);
+  }
+  arena_blocks_.clear();
+  arena_used_ = arena_capacity_ = 0;
+  iovecs_.clear();
+  size_ = 0;
+}
+
 Migrator::Migrator() {
   callback_triggered_ = true;
   run_background_loop();
@@ -111,17 +168,51 @@ Migrator::Migrator() {
 Migrator::~Migrator() {
   tcp_queue_->Shutdown();
   th_.Join();
+  if (!trace_path_.empty()) {
+    rt::access_once(trace_flusher_done_) = true;
+    trace_flusher_.Join();
+    dump_trace();
+  }
 }
 
-void Migrator::handle_copy_proclet(rt::TcpConn *c) {
-  ProcletHeader *proclet_header;
-  uint64_t start_addr, len;
-  const iovec iovecs[] = {{&proclet_header, sizeof(proclet_header)},
-                          {&start_addr, sizeof(start_addr)},
-                          {&len, sizeof(len)}};
-  BUG_ON(c->ReadvFull(std::span(iovecs), /* nt = */ false, /* poll = */ true) <=
-         0);
+void Migrator::set_trace_path(std::string path) {
+  BUG_ON(!trace_path_.empty());
+  trace_path_ = path;
+  if (trace_path_.empty()) {
+    return;
+  }
 
+  tracer_.enable();
+  trace_flusher_ = rt::Thread([&] {
+    uint64_t num_dumped = 0;
+    while (!rt::access_once(trace_flusher_done_)) {
+      timer_sleep(kTraceFlushIntervalUs);
+      auto num_finished = tracer_.get_num_finished_records();
+      if (num_finished != num_dumped) {
+        dump_trace();
+        num_dumped = num_finished;
+      }
+    }
+  });
+}
+
+void Migrator::dump_trace() {
+  rt::MutexGuard g(&trace_dump_mutex_);
+  std::ofstream records_ofs(trace_path_ + ".txt");
+  tracer_.write_records(records_ofs);
+  std::ofstream trace_ofs(trace_path_ + ".json");
+  tracer_.write_chrome_trace(trace_ofs);
+}
+
+// The status must have been moved off kPopulating under the migration spin,
+// which must not be held anymore as populators may take a while.
+static inline void wait_for_populators(ProcletHeader *proclet_header) {
+  while (unlikely(proclet_header->num_populators.load())) {
+    rt::Yield();
+  }
+}
+
+static inline void prepare_to_copy(ProcletHeader *proclet_header) {
   auto status = load_acquire(&proclet_header->status());
   if (unlikely(status == kDepopulating || status == kCleaning)) {
     ScopedLock l(&proclet_header->migration_spin());
@@ -131,10 +222,65 @@ void Migrator::handle_copy_proclet(rt::TcpConn *c) {
     }
     proclet_header->status() = kAbsent;
   }
+}
+
+uint32_t Migrator::handle_copy_proclet(rt::TcpConn *c) {
+  ProcletHeader *proclet_header;
+  uint32_t num_stripes;
+  uint64_t start_addr, len;
+  const iovec iovecs[] = {{&proclet_header, sizeof(proclet_header)},
+                          {&num_stripes, sizeof(num_stripes)},
+                          {&start_addr, sizeof(start_addr)},
+                          {&len, sizeof(len)}};
+  BUG_ON(c->ReadvFull(std::span(iovecs), /* nt = */ false, /* poll = */ true) <=
+         0);
+
+  prepare_to_copy(proclet_header);
 
   BUG_ON(c->ReadFull(reinterpret_cast<uint8_t *>(start_addr), len,
                      /* nt = */ true, /* poll = */ true) <= 0);
   proclet_header->pending_load_cnt--;
+  return num_stripes;
+}
+
+uint32_t Migrator::handle_copy_proclet_chunks(rt::TcpConn *c,
+                                              bool is_final) {
+  ProcletHeader *proclet_header;
+  uint32_t num_stripes;
+  uint64_t num_chunks;
+  const iovec iovecs[] = {{&proclet_header, sizeof(proclet_header)},
+                          {&num_stripes, sizeof(num_stripes)},
+                          {&num_chunks, sizeof(num_chunks)}};
+  BUG_ON(c->ReadvFull(std::span(iovecs), /* nt = */ false, /* poll = */ true) <=
+         0);
+
+  prepare_to_copy(proclet_header);
+
+  if (num_chunks) {
+    auto descs = std::make_unique<VAddrRange[]>(num_chunks);
+    BUG_ON(c->ReadFull(descs.get(), num_chunks * sizeof(VAddrRange),
+                       /* nt = */ false, /* poll = */ true) <= 0);
+
+    uint64_t max_end = 0;
+    for (uint64_t i = 0; i < num_chunks; i++) {
+      auto [start, end] = descs[i];
+      BUG_ON(c->ReadFull(reinterpret_cast<uint8_t *>(start), end - start,
+                         /* nt = */ true, /* poll = */ true) <= 0);
+      max_end = std::max(max_end, end);
+    }
+
+    // Lets depopulate_proclet() cover what has been pre-copied in case the
+    // proclet gets skipped in the end.
+    auto size = max_end - reinterpret_cast<uint64_t>(proclet_header);
+    if (!is_final && size > proclet_header->populate_size) {
+      proclet_header->populate_size = size;
+    }
+  }
+
+  if (is_final) {
+    proclet_header->pending_load_cnt--;
+  }
+  return num_stripes;
 }
 
 inline void Migrator::handle_load(rt::TcpConn *c) {
@@ -176,6 +322,9 @@ void Migrator::run_background_loop() {
             case kCopyProclet:
               handle_copy_proclet(c);
               break;
+            case kCopyProcletDelta:
+              handle_copy_proclet_chunks(c, /* is_final = */ true);
+              break;
             case kMigrate:
               handle_load(c);
               break;
@@ -210,87 +359,465 @@ void Migrator::run_background_loop() {
   });
 }
 
-inline void throttle(uint64_t len, uint64_t real_us) {
-  uint64_t expected_us = len / Migrator::kMigrationThrottleGBs / 1000;
-  if (expected_us > real_us) {
-    delay_us(expected_us - real_us);
+void Migrator::set_bandwidth_budget(float gbs) {
+  max_bandwidth_budget_gbs_ = gbs;
+  bandwidth_budget_.set_rate(gbs * 1e9);
+}
+
+float Migrator::get_bandwidth_budget() {
+  return bandwidth_budget_.get_rate() / 1e9;
+}
+
+void Migrator::adjust_bandwidth_budget() {
+  auto now_us = microtime();
+  auto last_us = last_budget_adjust_us_.load(std::memory_order_relaxed);
+  if (now_us - last_us < kBandwidthBudgetAdjustIntervalUs ||
+      !last_budget_adjust_us_.compare_exchange_strong(last_us, now_us)) {
+    return;
+  }
+
+  auto max_rate = static_cast<uint64_t>(max_bandwidth_budget_gbs_ * 1e9);
+  auto min_rate = std::min(max_rate,
+                           static_cast<uint64_t>(kMinBandwidthBudgetGBs * 1e9));
+  auto rate = bandwidth_budget_.get_rate();
+  auto latency_us = foreground_latency_tsc_.load() / cycles_per_us;
+  if (latency_us > kForegroundLatencyTargetUs) {
+    rate = std::max(rate / 2, min_rate);
+  } else {
+    rate = std::min(rate + max_rate / kBandwidthBudgetRecoverySteps, max_rate);
+  }
+  bandwidth_budget_.set_rate(rate);
+}
+
+void Migrator::transmit_budgeted(rt::TcpConn *c, std::span<const iovec> iovecs,
+                                 bool nt, bool poll) {
+  if (!max_bandwidth_budget_gbs_) {
+    BUG_ON(c->WritevFull(iovecs, nt, poll) < 0);
+    return;
+  }
+
+  num_budgeted_transfers_++;
+  std::vector<iovec> quantum;
+  uint64_t quantum_len = 0;
+  auto flush = [&] {
+    adjust_bandwidth_budget();
+    bandwidth_budget_.consume(quantum_len);
+    BUG_ON(c->WritevFull(std::span<const iovec>(quantum), nt, poll) < 0);
+    quantum.clear();
+    quantum_len = 0;
+  };
+  for (auto [base, len] : iovecs) {
+    auto *data = reinterpret_cast<uint8_t *>(base);
+    while (len) {
+      auto piece = std::min(len, kBandwidthBudgetQuantum - quantum_len);
+      quantum.push_back({data, piece});
+      quantum_len += piece;
+      data += piece;
+      len -= piece;
+      if (quantum_len == kBandwidthBudgetQuantum) {
+        flush();
+      }
+    }
   }
+  if (quantum_len) {
+    flush();
+  }
+  num_budgeted_transfers_--;
 }
 
-void Migrator::transmit_proclet(rt::TcpConn *c, ProcletHeader *proclet_header) {
-  constexpr bool kMonitorTime =
-      (kEnableLogging || kMigrationThrottleGBs > 0 || kMigrationDelayUs);
+static inline uint64_t get_heap_end(ProcletHeader *proclet_header) {
+  return reinterpret_cast<uint64_t>(proclet_header->slab.get_base()) +
+         proclet_header->slab.get_usage();
+}
+
+uint64_t Migrator::transmit_proclet(rt::TcpConn *c,
+                                    ProcletHeader *proclet_header,
+                                    PreCopyState *precopy_state,
+                                    MigrationRecord *record) {
+  constexpr bool kMonitorTime = (kEnableLogging || kMigrationDelayUs);
   [[maybe_unused]] uint64_t t0, t1;
 
   if constexpr (kMonitorTime) {
     t0 = microtime();
   }
 
+  uint64_t len = 0;
+  if (precopy_state) {
+    auto chunks = get_final_delta(proclet_header, precopy_state);
+    for (auto &chunk : chunks) {
+      len += chunk.len;
+    }
+    transmit_chunks(c, proclet_header, kCopyProcletDelta, chunks,
+                    get_num_stripes(c, len), record);
+  } else {
+    len = transmit_whole_proclet(c, proclet_header, record);
+  }
+
+  if constexpr (kMonitorTime) {
+    t1 = microtime();
+  }
+
+  if constexpr (kMigrationDelayUs) {
+    auto remote_ip = c->RemoteAddr().ip;
+    auto delayed = delayed_srv_ips_.contains(remote_ip);
+    if (!delayed) {
+      delayed_srv_ips_.insert(remote_ip);
+      delay_us(kMigrationDelayUs);
+      t1 = microtime();
+    }
+  }
+
+  if constexpr (kEnableLogging) {
+    Caladan::PreemptGuard g;
+
+    std::osyncstream synced_out(std::cout);
+    synced_out << "Transmit proclet: addr = " << proclet_header
+               << ", size = " << len << ", time_us = " << t1 - t0
+               << ", precopied = " << (precopy_state != nullptr)
+               << ", num proclets left = "
+               << get_runtime()->proclet_manager()->get_num_present_proclets()
+               << std::endl;
+  }
+
+  return len;
+}
+
+uint32_t Migrator::get_num_stripes(rt::TcpConn *c, uint64_t len) {
+  // The aux handlers may be polling the connections to another destination.
+  if (c->RemoteAddr().ip != aux_handlers_dest_ip_) {
+    return 1;
+  }
+  auto max_num_stripes =
+      get_runtime()->pressure_handler()->get_num_aux_handlers() + 1;
+  return std::clamp<uint64_t>(len / kMinStripeSize, 1, max_num_stripes);
+}
+
+// Drops the parts of the chunks that fall into the free regions. Both must be
+// sorted.
+static std::vector<Migrator::CopyChunk> skip_free_regions(
+    const std::vector<Migrator::CopyChunk> &chunks,
+    const std::vector<VAddrRange> &free_regions) {
+  std::vector<Migrator::CopyChunk> live_chunks;
+  auto it = free_regions.begin();
+  for (auto [addr, len, src] : chunks) {
+    auto end = addr + len;
+    while (addr < end) {
+      while (it != free_regions.end() && it->end <= addr) {
+        ++it;
+      }
+      auto live_end = (it == free_regions.end()) ? end
+                                                 : std::min(end, it->start);
+      if (addr < live_end) {
+        live_chunks.push_back(Migrator::CopyChunk{
+            .addr = addr, .len = live_end - addr, .src = src});
+        src = reinterpret_cast<const uint8_t *>(src) + (live_end - addr);
+        addr = live_end;
+      }
+      if (addr < end) {
+        auto free_end = std::min(end, it->end);
+        src = reinterpret_cast<const uint8_t *>(src) + (free_end - addr);
+        addr = free_end;
+      }
+    }
+  }
+  return live_chunks;
+}
+
+uint64_t Migrator::transmit_whole_proclet(rt::TcpConn *c,
+                                          ProcletHeader *proclet_header,
+                                          MigrationRecord *record) {
   uint8_t type = kCopyProclet;
   auto start_addr = reinterpret_cast<uint64_t>(proclet_header->copy_start);
-  auto len = (reinterpret_cast<uint64_t>(proclet_header->slab.get_base()) -
-              start_addr) +
-             proclet_header->slab.get_usage();
-  auto per_thread_len = (len - 1) / kTransmitProcletNumThreads + 1;
-  uint64_t req_start_addrs[kTransmitProcletNumThreads];
-  uint64_t req_lens[kTransmitProcletNumThreads];
-
-  for (uint32_t i = 0; i < kTransmitProcletNumThreads; i++) {
+  auto len = get_heap_end(proclet_header) - start_addr;
+
+  // Freed blocks carry no data, so only the live parts of the heap are sent.
+  auto free_regions =
+      proclet_header->slab.get_free_regions(kMinSkippedFreeRegionSize);
+  if (!free_regions.empty()) {
+    std::vector<CopyChunk> chunks{
+        {.addr = start_addr,
+         .len = len,
+         .src = reinterpret_cast<const void *>(start_addr)}};
+    chunks = skip_free_regions(chunks, free_regions);
+    len = 0;
+    for (auto &chunk : chunks) {
+      len += chunk.len;
+    }
+    transmit_chunks(c, proclet_header, kCopyProcletDelta, chunks,
+                    get_num_stripes(c, len), record);
+    return len;
+  }
+
+  auto start_tsc = rdtsc();
+  auto num_stripes = get_num_stripes(c, len);
+  auto per_thread_len = (len - 1) / num_stripes + 1;
+  uint64_t req_start_addrs[kMaxTransmitProcletNumThreads];
+  uint64_t req_lens[kMaxTransmitProcletNumThreads];
+
+  for (uint32_t i = 0; i < num_stripes; i++) {
     req_start_addrs[i] = start_addr + i * per_thread_len;
-    req_lens[i] = (i != kTransmitProcletNumThreads - 1)
+    req_lens[i] = (i != num_stripes - 1)
                       ? per_thread_len
                       : start_addr + len - req_start_addrs[i];
     std::vector<iovec> task{
         {&type, sizeof(type)},
         {&proclet_header, sizeof(proclet_header)},
+        {&num_stripes, sizeof(num_stripes)},
         {&req_start_addrs[i], sizeof(req_start_addrs[i])},
         {&req_lens[i], sizeof(req_lens[i])},
         {reinterpret_cast<std::byte *>(req_start_addrs[i]), req_lens[i]}};
-    if (i < PressureHandler::kNumAuxHandlers) {
+    if (i + 1 < num_stripes) {
       // Dispatch to aux handler.
       get_runtime()->pressure_handler()->dispatch_aux_tcp_task(i,
                                                                std::move(task));
     } else {
       // Execute the task itself.
-      BUG_ON(c->WritevFull(std::span<const iovec>(task), /* nt = */ true,
-                           /* poll = */ true) < 0);
+      transmit_budgeted(c, task, /* nt = */ true);
     }
   }
 
-  get_runtime()->pressure_handler()->wait_aux_tasks();
+  if (num_stripes > 1) {
+    get_runtime()->pressure_handler()->wait_aux_tasks();
+  }
+  trace_stripes(record, proclet_header, num_stripes, start_tsc);
+  return len;
+}
 
-  if constexpr (kMonitorTime) {
-    t1 = microtime();
+void Migrator::trace_stripes(MigrationRecord *record,
+                             ProcletHeader *proclet_header,
+                             uint32_t num_stripes, uint64_t start_tsc) {
+  if (!record) {
+    return;
   }
 
-  if constexpr (kMigrationThrottleGBs > 0) {
-    throttle(len, t1 - t0);
-    t1 = microtime();
+  auto id = to_proclet_id(proclet_header);
+  record->add(MigrationSpan::kTransmitHeap, start_tsc, rdtsc(), id);
+  for (uint32_t i = 0; i + 1 < num_stripes; i++) {
+    auto [aux_start_tsc, aux_end_tsc] =
+        get_runtime()->pressure_handler()->get_aux_task_tsc(i);
+    record->add(MigrationSpan::kTransmitHeap, aux_start_tsc, aux_end_tsc, id,
+                i + 1);
   }
+}
 
-  if constexpr (kMigrationDelayUs) {
-    auto remote_ip = c->RemoteAddr().ip;
-    auto delayed = delayed_srv_ips_.contains(remote_ip);
-    if (!delayed) {
-      delayed_srv_ips_.insert(remote_ip);
-      delay_us(kMigrationDelayUs);
-      t1 = microtime();
+void Migrator::transmit_chunks(rt::TcpConn *c, ProcletHeader *proclet_header,
+                               uint8_t type,
+                               const std::vector<CopyChunk> &chunks,
+                               uint32_t num_stripes, MigrationRecord *record) {
+  BUG_ON(num_stripes > kMaxTransmitProcletNumThreads);
+  auto start_tsc = rdtsc();
+
+  uint64_t total_len = 0;
+  for (auto &chunk : chunks) {
+    total_len += chunk.len;
+  }
+  auto per_stripe_len =
+      std::max<uint64_t>(total_len / num_stripes + 1, kPageSize);
+
+  // Every stripe sends exactly one message, even if it is empty.
+  struct Stripe {
+    uint64_t num_chunks;
+    std::vector<VAddrRange> descs;
+    std::vector<iovec> datas;
+  };
+  Stripe stripes[kMaxTransmitProcletNumThreads];
+
+  uint32_t idx = 0;
+  uint64_t cur_len = 0;
+  for (auto [addr, len, src] : chunks) {
+    while (len) {
+      if (cur_len == per_stripe_len && idx + 1 < num_stripes) {
+        idx++;
+        cur_len = 0;
+      }
+      auto piece = (idx + 1 < num_stripes)
+                       ? std::min(len, per_stripe_len - cur_len)
+                       : len;
+      stripes[idx].descs.push_back(
+          VAddrRange{.start = addr, .end = addr + piece});
+      stripes[idx].datas.push_back(
+          {const_cast<void *>(src), static_cast<size_t>(piece)});
+      addr += piece;
+      src = reinterpret_cast<const uint8_t *>(src) + piece;
+      len -= piece;
+      cur_len += piece;
     }
   }
 
-  if constexpr (kEnableLogging) {
-    Caladan::PreemptGuard g;
+  for (uint32_t i = 0; i < num_stripes; i++) {
+    auto &stripe = stripes[i];
+    stripe.num_chunks = stripe.descs.size();
+    std::vector<iovec> task{
+        {&type, sizeof(type)},
+        {&proclet_header, sizeof(proclet_header)},
+        {&num_stripes, sizeof(num_stripes)},
+        {&stripe.num_chunks, sizeof(stripe.num_chunks)},
+        {stripe.descs.data(), stripe.num_chunks * sizeof(VAddrRange)}};
+    task.insert(task.end(), stripe.datas.begin(), stripe.datas.end());
+    if (i + 1 < num_stripes) {
+      // Dispatch to aux handler.
+      get_runtime()->pressure_handler()->dispatch_aux_tcp_task(i,
+                                                               std::move(task));
+    } else {
+      // Execute the task itself.
+      transmit_budgeted(c, task, /* nt = */ true);
+    }
+  }
 
-    std::osyncstream synced_out(std::cout);
-    synced_out << "Transmit proclet: addr = " << proclet_header
-               << ", size = " << len << ", time_us = " << t1 - t0
-               << ", num proclets left = "
-               << get_runtime()->proclet_manager()->get_num_present_proclets()
-               << std::endl;
+  if (num_stripes > 1) {
+    get_runtime()->pressure_handler()->wait_aux_tasks();
   }
+  trace_stripes(record, proclet_header, num_stripes, start_tsc);
 }
 
-void Migrator::transmit_mutexes(rt::TcpConn *c, std::vector<Mutex *> mutexes) {
+// Returns whether the page content differs from what was last sent, in which
+// case the recorded hash is updated.
+static inline bool update_page_hash(auto *state, uint64_t addr,
+                                    const void *content, uint64_t len) {
+  auto hash = util::Hash64(reinterpret_cast<const char *>(content), len) | 1;
+  auto &recorded = state->page_hashes[addr];
+  if (recorded == hash) {
+    return false;
+  }
+  recorded = hash;
+  return true;
+}
+
+std::unique_ptr<Migrator::PreCopyState> Migrator::precopy_proclet(
+    rt::TcpConn *c, ProcletHeader *proclet_header) {
+  if constexpr (!kEnablePreCopy) {
+    return nullptr;
+  }
+
+  auto start_addr = reinterpret_cast<uint64_t>(proclet_header->copy_start);
+  auto end_addr = get_heap_end(proclet_header);
+  if (end_addr - start_addr < kPreCopyMinHeapSize) {
+    return nullptr;
+  }
+
+  auto state = std::make_unique<PreCopyState>();
+  if (unlikely(!state->tracker.start())) {
+    return nullptr;
+  }
+  state->generation = proclet_header->generation;
+
+  // The first round sends the whole heap as the proclet keeps running.
+  std::vector<CopyChunk> chunks{
+      {.addr = start_addr,
+       .len = end_addr - start_addr,
+       .src = reinterpret_cast<const void *>(start_addr)}};
+  transmit_chunks(c, proclet_header, kPreCopyProclet, chunks,
+                  /* num_stripes = */ 1);
+  state->end_addr = end_addr;
+  state->sent_len = end_addr - start_addr;
+
+  for (uint32_t i = 1; i < kPreCopyMaxRounds; i++) {
+    auto sent_len = precopy_round(c, proclet_header, state.get());
+    state->sent_len += sent_len;
+    if (sent_len < kPreCopyStopBytes) {
+      break;
+    }
+  }
+  return state;
+}
+
+uint64_t Migrator::precopy_round(rt::TcpConn *c, ProcletHeader *proclet_header,
+                                 PreCopyState *state) {
+  auto start_addr = reinterpret_cast<uint64_t>(proclet_header->copy_start);
+  std::vector<VAddrRange> dirty_ranges;
+  state->tracker.get_dirty_ranges(start_addr, state->end_addr, &dirty_ranges);
+
+  // Pages are snapshotted before being hashed and sent, as the proclet may
+  // modify them at any time.
+  auto snapshot = std::make_unique_for_overwrite<uint8_t[]>(kPreCopyBatchSize);
+  uint64_t snapshot_len = 0;
+  uint64_t sent_len = 0;
+  std::vector<CopyChunk> chunks;
+  auto flush = [&] {
+    if (!chunks.empty()) {
+      transmit_chunks(c, proclet_header, kPreCopyProclet, chunks,
+                      /* num_stripes = */ 1);
+    }
+    sent_len += snapshot_len;
+    snapshot_len = 0;
+    chunks.clear();
+  };
+
+  for (auto [range_start, range_end] : dirty_ranges) {
+    for (auto page = range_start; page < range_end; page += kPageSize) {
+      auto addr = std::max(page, start_addr);
+      auto len = std::min(page + kPageSize, state->end_addr) - addr;
+      auto *buf = snapshot.get() + snapshot_len;
+      memcpy(buf, reinterpret_cast<const void *>(addr), len);
+      if (!update_page_hash(state, page, buf, len)) {
+        continue;
+      }
+      snapshot_len += len;
+      if (!chunks.empty() && chunks.back().addr + chunks.back().len == addr) {
+        chunks.back().len += len;
+      } else {
+        chunks.push_back(CopyChunk{.addr = addr, .len = len, .src = buf});
+      }
+      if (snapshot_len + kPageSize > kPreCopyBatchSize) {
+        flush();
+      }
+    }
+  }
+  flush();
+
+  // The newly allocated part of the heap.
+  auto end_addr = get_heap_end(proclet_header);
+  if (end_addr > state->end_addr) {
+    chunks.push_back(
+        CopyChunk{.addr = state->end_addr,
+                  .len = end_addr - state->end_addr,
+                  .src = reinterpret_cast<const void *>(state->end_addr)});
+    transmit_chunks(c, proclet_header, kPreCopyProclet, chunks,
+                    /* num_stripes = */ 1);
+    sent_len += end_addr - state->end_addr;
+    state->end_addr = end_addr;
+  }
+
+  return sent_len;
+}
+
+std::vector<Migrator::CopyChunk> Migrator::get_final_delta(
+    ProcletHeader *proclet_header, PreCopyState *state) {
+  auto start_addr = reinterpret_cast<uint64_t>(proclet_header->copy_start);
+  std::vector<VAddrRange> dirty_ranges;
+  state->tracker.get_dirty_ranges(start_addr, state->end_addr, &dirty_ranges);
+
+  // The proclet is paused, so the pages can be sent in place.
+  std::vector<CopyChunk> chunks;
+  auto append = [&](uint64_t addr, uint64_t len) {
+    if (!chunks.empty() && chunks.back().addr + chunks.back().len == addr) {
+      chunks.back().len += len;
+    } else {
+      chunks.push_back(CopyChunk{
+          .addr = addr, .len = len, .src = reinterpret_cast<void *>(addr)});
+    }
+  };
+
+  // Every dirtied page is resent, as a hash collision here would leave a
+  // stale page behind for good.
+  for (auto [range_start, range_end] : dirty_ranges) {
+    auto addr = std::max(range_start, start_addr);
+    auto end = std::min(range_end, state->end_addr);
+    if (addr < end) {
+      append(addr, end - addr);
+    }
+  }
+
+  auto end_addr = get_heap_end(proclet_header);
+  if (end_addr > state->end_addr) {
+    append(state->end_addr, end_addr - state->end_addr);
+  }
+  return skip_free_regions(
+      chunks, proclet_header->slab.get_free_regions(kMinSkippedFreeRegionSize));
+}
+
+template <typename Conn>
+void Migrator::transmit_mutexes(Conn *c, std::vector<Mutex *> mutexes) {
   size_t num_mutexes = mutexes.size();
 
   if (num_mutexes) {
@@ -313,18 +840,13 @@ void Migrator::transmit_mutexes(rt::TcpConn *c, std::vector<Mutex *> mutexes) {
           reinterpret_cast<uintptr_t>(th) + thread_link_offset);
       list_add_tail(&all_migrating_ths, th_link);
     }
-    size_t num_threads = ths.size();
-    BUG_ON(!num_threads);
-    BUG_ON(c->WriteFull(&num_threads, sizeof(num_threads), /* nt = */ false,
-                        /* poll = */ true) < 0);
-    for (auto th : ths) {
-      transmit_one_thread(c, th);
-    }
+    BUG_ON(ths.empty());
+    transmit_threads(c, ths);
   }
 }
 
-void Migrator::transmit_condvars(rt::TcpConn *c,
-                                 std::vector<CondVar *> condvars) {
+template <typename Conn>
+void Migrator::transmit_condvars(Conn *c, std::vector<CondVar *> condvars) {
   size_t num_condvars = condvars.size();
 
   if (num_condvars) {
@@ -348,17 +870,13 @@ void Migrator::transmit_condvars(rt::TcpConn *c,
           reinterpret_cast<uintptr_t>(th) + thread_link_offset);
       list_add_tail(&all_migrating_ths, th_link);
     }
-    size_t num_threads = ths.size();
-    BUG_ON(!num_threads);
-    BUG_ON(c->WriteFull(&num_threads, sizeof(num_threads), /* nt = */ false,
-                        /* poll = */ true) < 0);
-    for (auto th : ths) {
-      transmit_one_thread(c, th);
-    }
+    BUG_ON(ths.empty());
+    transmit_threads(c, ths);
   }
 }
 
-void Migrator::transmit_time(rt::TcpConn *c, Time *time) {
+template <typename Conn>
+void Migrator::transmit_time(Conn *c, Time *time) {
   uint64_t migrator_tsc = rdtscp(nullptr) - start_tsc;
   int64_t sum_tsc = migrator_tsc + time->offset_tsc_;
 
@@ -377,37 +895,57 @@ void Migrator::transmit_time(rt::TcpConn *c, Time *time) {
                         sizeof(timer_entry *) * num_entries,
                         /* nt = */ false, /* poll = */ true) < 0);
 
+    std::vector<thread_t *> ths;
+    ths.reserve(num_entries);
     for (size_t i = 0; i < num_entries; i++) {
       auto *entry = timer_entries_arr[i];
       timer_cancel(entry);
       auto *arg = reinterpret_cast<TimerCallbackArg *>(entry->arg);
-      transmit_one_thread(c, arg->th);
+      ths.push_back(arg->th);
     }
+    transmit_threads(c, ths);
   }
 }
 
-void Migrator::transmit_one_thread(rt::TcpConn *c, thread_t *thread) {
-  size_t nu_state_size;
-  auto *nu_state = thread_get_nu_state(thread, &nu_state_size);
-  BUG_ON(c->WriteFull(nu_state, nu_state_size, /* nt = */ false,
-                      /* poll = */ true) < 0);
+template <typename Conn>
+void Migrator::transmit_thread_batch(Conn *c,
+                                     std::span<thread_t *const> threads) {
+  // All nu states go first, so that the loader can restore the threads and
+  // learn where their stacks belong before receiving them.
+  std::vector<iovec> iovecs;
+  iovecs.reserve(threads.size() * 2);
+  for (auto *thread : threads) {
+    size_t nu_state_size;
+    auto *nu_state = thread_get_nu_state(thread, &nu_state_size);
+    iovecs.push_back({nu_state, nu_state_size});
+  }
+  for (auto *thread : threads) {
+    auto stack_range = get_runtime()->get_proclet_stack_range(thread);
+    iovecs.push_back({reinterpret_cast<void *>(stack_range.start),
+                      stack_range.end - stack_range.start});
+  }
+  BUG_ON(c->WritevFull(std::span<const iovec>(iovecs), /* nt = */ false,
+                       /* poll = */ true) < 0);
 
-  auto stack_range = get_runtime()->get_proclet_stack_range(thread);
-  auto stack_len = stack_range.end - stack_range.start;
-  BUG_ON(c->WriteFull(reinterpret_cast<void *>(stack_range.start), stack_len,
-                      /* nt = */ false,
-                      /* poll = */ true) < 0);
-  get_runtime()->stack_manager()->free(
-      reinterpret_cast<uint8_t *>(stack_range.end));
+  for (auto *thread : threads) {
+    auto stack_range = get_runtime()->get_proclet_stack_range(thread);
+    get_runtime()->stack_manager()->free(
+        reinterpret_cast<uint8_t *>(stack_range.end));
+  }
 }
 
-void Migrator::transmit_threads(rt::TcpConn *c,
+template <typename Conn>
+void Migrator::transmit_threads(Conn *c,
                                 const std::vector<thread_t *> &threads) {
   uint64_t num_threads = threads.size();
   BUG_ON(c->WriteFull(&num_threads, sizeof(num_threads), /* nt = */ false,
                       /* poll = */ true) < 0);
-  for (auto thread : threads) {
-    transmit_one_thread(c, thread);
+  std::span<thread_t *const> remaining(threads);
+  while (!remaining.empty()) {
+    auto batch_size =
+        std::min(remaining.size(), static_cast<size_t>(kThreadBatchSize));
+    transmit_thread_batch(c, remaining.first(batch_size));
+    remaining = remaining.subspan(batch_size);
   }
 }
 
@@ -429,13 +967,84 @@ void Migrator::transmit_proclet_migration_tasks(
 
 void Migrator::update_proclet_location(rt::TcpConn *c,
                                        ProcletHeader *proclet_header) {
-  get_runtime()->controller_client()->update_location(
-      to_proclet_id(proclet_header), c->RemoteAddr().ip);
+  auto id = to_proclet_id(proclet_header);
+  ProcletLocation location;
+  location.ip = c->RemoteAddr().ip;
+  location.epoch = proclet_header->location_epoch;
+  proclet_header->forward_location() = location;
+  if constexpr (kHoldRequestsDuringMigration) {
+    // Releases the requests held during the migration with the new location.
+    ScopedLock lock(&proclet_header->spin_lock);
+    proclet_header->cond_var.signal_all();
+  }
+  bool full;
+  {
+    rt::SpinGuard g(&location_updates_spin_);
+    pending_location_updates_.push_back(
+        {id, location.raw, proclet_header->location_generation});
+    full = pending_location_updates_.size() >= kMaxLocationUpdatesBatchSize;
+  }
+  if (unlikely(full)) {
+    rt::Spawn([this] { publish_proclet_locations(); });
+  }
+  rt::Spawn([id, location, caller_ips = proclet_header->callers.get_all()] {
+    push_proclet_location(id, location, caller_ips);
+  });
+}
+
+void Migrator::wait_until_loaded(ProcletHeader *proclet_header) {
+  if (likely(load_acquire(&proclet_header->status()) != kPopulating)) {
+    return;
+  }
+
+  ScopedLock lock(&loading_spin_);
+  while (Caladan::access_once(proclet_header->status()) == kPopulating) {
+    loading_cond_var_.wait(&loading_spin_);
+  }
+}
+
+void Migrator::notify_loaded() {
+  ScopedLock lock(&loading_spin_);
+  loading_cond_var_.signal_all();
 }
 
-void Migrator::transmit(rt::TcpConn *c, ProcletHeader *proclet_header,
-                        struct list_head *paused_ths_list) {
-  transmit_proclet(c, proclet_header);
+void Migrator::publish_proclet_locations() {
+  std::vector<ProcletLocationUpdate> updates;
+  {
+    rt::SpinGuard g(&location_updates_spin_);
+    updates.swap(pending_location_updates_);
+  }
+  if (!updates.empty()) {
+    get_runtime()->controller_client()->update_locations(updates);
+  }
+}
+
+void Migrator::push_proclet_location(ProcletID id, ProcletLocation location,
+                                     const std::vector<NodeIP> &caller_ips) {
+  auto *rpc_client_mgr = get_runtime()->rpc_client_mgr();
+  rpc_client_mgr->update_cache(id, location);
+
+  // Best effort. Stale pushes are filtered out by the location epoch.
+  RPCReqUpdateCache req;
+  req.id = id;
+  req.location_raw = location.raw;
+  for (auto ip : caller_ips) {
+    if (ip == location.ip || ip == get_cfg_ip()) {
+      continue;
+    }
+    RPCReturnBuffer return_buf;
+    rpc_client_mgr->get_by_ip(ip)->Call(to_span(req), &return_buf);
+  }
+}
+
+uint64_t Migrator::transmit(rt::TcpConn *c, ProcletHeader *proclet_header,
+                            struct list_head *paused_ths_list,
+                            PreCopyState *precopy_state,
+                            MigrationBatchWriter *batch,
+                            MigrationRecord *record) {
+  if (unlikely(!++proclet_header->location_epoch)) {
+    proclet_header->location_epoch++;
+  }
 
   std::vector<thread_t *> ready_threads;
   std::vector<Mutex *> mutexes;
@@ -461,12 +1070,64 @@ void Migrator::transmit(rt::TcpConn *c, ProcletHeader *proclet_header,
     }
   }
 
-  transmit_mutexes(c, mutexes);
-  transmit_condvars(c, condvars);
-  transmit_threads(c, ready_threads);
-  transmit_time(c, &proclet_header->time);
+  auto id = to_proclet_id(proclet_header);
+  auto transmit_rest = [&](auto *conn) {
+    {
+      MigrationSpanGuard g(record, MigrationSpan::kTransmitMutexes, id);
+      transmit_mutexes(conn, mutexes);
+    }
+    {
+      MigrationSpanGuard g(record, MigrationSpan::kTransmitCondVars, id);
+      transmit_condvars(conn, condvars);
+    }
+    {
+      MigrationSpanGuard g(record, MigrationSpan::kTransmitThreads, id);
+      transmit_threads(conn, ready_threads);
+    }
+    {
+      MigrationSpanGuard g(record, MigrationSpan::kTransmitTime, id);
+      transmit_time(conn, &proclet_header->time);
+    }
+  };
+
+  if (batch) {
+    // The controller learns about the new location once the batch is out.
+    {
+      MigrationSpanGuard g(record, MigrationSpan::kTransmitHeap, id);
+      transmit_small_proclet(batch, proclet_header);
+    }
+    transmit_rest(batch);
+    return 0;
+  }
 
+  auto len = transmit_proclet(c, proclet_header, precopy_state, record);
+  transmit_rest(c);
+
+  MigrationSpanGuard g(record, MigrationSpan::kUpdateLocation, id);
   update_proclet_location(c, proclet_header);
+  return len;
+}
+
+bool Migrator::is_coalescable(ProcletHeader *proclet_header) {
+  auto start_addr = reinterpret_cast<uint64_t>(proclet_header->copy_start);
+  return get_heap_end(proclet_header) - start_addr <= kMaxCoalescedProcletSize;
+}
+
+void Migrator::transmit_small_proclet(MigrationBatchWriter *batch,
+                                      ProcletHeader *proclet_header) {
+  uint8_t type = kCopyProclet;
+  uint32_t num_stripes = 1;
+  uint64_t start_addr = reinterpret_cast<uint64_t>(proclet_header->copy_start);
+  uint64_t len = get_heap_end(proclet_header) - start_addr;
+  const iovec iovecs[] = {{&type, sizeof(type)},
+                          {&proclet_header, sizeof(proclet_header)},
+                          {&num_stripes, sizeof(num_stripes)},
+                          {&start_addr, sizeof(start_addr)},
+                          {&len, sizeof(len)}};
+  batch->WritevFull(std::span(iovecs));
+  // The heap stays intact until the batch is flushed, as its cleanup is
+  // deferred until then.
+  batch->write_ref(reinterpret_cast<const void *>(start_addr), len);
 }
 
 bool Migrator::try_mark_proclet_migrating(ProcletHeader *proclet_header) {
@@ -482,29 +1143,49 @@ bool Migrator::try_mark_proclet_migrating(ProcletHeader *proclet_header) {
   return true;
 }
 
-void Migrator::aux_handlers_enable_polling(uint32_t dest_ip) {
-  uint8_t type = kEnablePoll;
+void Migrator::StopCopyLock::lock() {
+  while (!spin_.try_lock()) {
+    get_runtime()->caladan()->unblock_and_relax();
+  }
+}
+
+void Migrator::StopCopyLock::unlock() { spin_.unlock(); }
+
+bool Migrator::aux_handlers_enable_polling(uint32_t dest_ip) {
+  NodeIP expected = 0;
+  if (!aux_handlers_dest_ip_.compare_exchange_strong(expected, dest_ip)) {
+    return false;
+  }
+
+  auto *pressure_handler = get_runtime()->pressure_handler();
+  std::vector<MigratorConn> aux_migration_conns;
+  for (uint32_t i = 0; i < pressure_handler->get_num_aux_handlers(); i++) {
+    aux_migration_conns.push_back(migrator_conn_mgr_.get(dest_ip));
+  }
 
-  for (uint32_t i = 0; i < PressureHandler::kNumAuxHandlers; i++) {
-    auto aux_migration_conn = migrator_conn_mgr_.get(dest_ip);
-    get_runtime()->pressure_handler()->update_aux_handler_state(
-        i, std::move(aux_migration_conn));
+  ScopedLock stop_copy_guard(&stop_copy_lock_);
+  uint8_t type = kEnablePoll;
+  for (uint32_t i = 0; i < pressure_handler->get_num_aux_handlers(); i++) {
+    pressure_handler->update_aux_handler_state(
+        i, std::move(aux_migration_conns[i]));
     std::vector<iovec> task{{&type, sizeof(type)}};
-    get_runtime()->pressure_handler()->dispatch_aux_tcp_task(i,
-                                                             std::move(task));
+    pressure_handler->dispatch_aux_tcp_task(i, std::move(task));
   }
-  get_runtime()->pressure_handler()->wait_aux_tasks();
+  pressure_handler->wait_aux_tasks();
+  return true;
 }
 
 void Migrator::aux_handlers_disable_polling() {
+  ScopedLock stop_copy_guard(&stop_copy_lock_);
   uint8_t type = kDisablePoll;
 
-  for (uint32_t i = 0; i < PressureHandler::kNumAuxHandlers; i++) {
+  auto *pressure_handler = get_runtime()->pressure_handler();
+  for (uint32_t i = 0; i < pressure_handler->get_num_aux_handlers(); i++) {
     std::vector<iovec> task{{&type, sizeof(type)}};
-    get_runtime()->pressure_handler()->dispatch_aux_tcp_task(i,
-                                                             std::move(task));
+    pressure_handler->dispatch_aux_tcp_task(i, std::move(task));
   }
-  get_runtime()->pressure_handler()->wait_aux_tasks();
+  pressure_handler->wait_aux_tasks();
+  aux_handlers_dest_ip_ = 0;
 }
 
 void Migrator::callback() {
@@ -522,44 +1203,143 @@ uint32_t Migrator::migrate(
     callback();
   }
 
+  // An estimate left over from an earlier migration would throttle this one
+  // right away.
+  foreground_latency_tsc_.store(0, std::memory_order_relaxed);
+
   std::set<NodeIP> congested_dests;
-  auto it = tasks.begin();
-  std::vector<ProcletMigrationTask> cur_round_tasks;
+  auto pending_tasks = tasks;
 
-  while (it != tasks.end() &&
+  while (!pending_tasks.empty() &&
          get_runtime()->pressure_handler()->has_pressure()) {
     auto has_mem_pressure =
         get_runtime()->pressure_handler()->has_mem_pressure();
-    auto [dest_guard, dest_resource] =
-        get_runtime()->controller_client()->acquire_migration_dest(
-            has_mem_pressure, it->second);
-    auto dest_ip = dest_guard.get_ip();
-    if (unlikely(!dest_guard || congested_dests.contains(dest_ip))) {
+    auto lanes = plan_migration_lanes(has_mem_pressure, &pending_tasks,
+                                      congested_dests);
+    if (unlikely(lanes.empty())) {
       break;
     }
 
-    cur_round_tasks.clear();
-    Resource cur_round_resource{.cores = 0, .mem_mbs = 0};
-    for (auto tmp = it; tmp != tasks.end(); ++tmp) {
-      cur_round_resource += tmp->second;
-      bool too_much = cur_round_resource.mem_mbs > dest_resource.mem_mbs;
-      if (!has_mem_pressure) {
-        too_much |= cur_round_resource.cores > dest_resource.cores;
+    std::vector<uint32_t> nums_migrated(lanes.size());
+    auto migrate_lane = [&](uint32_t i) {
+      std::vector<ProcletMigrationTask> lane_tasks;
+      for (auto &[task, resource] : lanes[i].tasks) {
+        lane_tasks.push_back(task);
       }
-      if (too_much) {
-        break;
+      nums_migrated[i] =
+          __migrate(lanes[i].dest->first, has_mem_pressure, lane_tasks);
+    };
+    // The first lane stays on the pressure handler. Since the handler must
+    // not park, it spins for the others.
+    std::atomic<uint32_t> num_running_lanes = lanes.size() - 1;
+    for (uint32_t i = 1; i < lanes.size(); i++) {
+      rt::Spawn([&, i] {
+        migrate_lane(i);
+        num_running_lanes--;
+      });
+    }
+    migrate_lane(0);
+    while (num_running_lanes.load()) {
+      get_runtime()->caladan()->unblock_and_relax();
+    }
+
+    // The proclets that a destination did not take get retried elsewhere,
+    // ahead of the ones that have not been planned yet.
+    std::vector<std::pair<ProcletMigrationTask, Resource>> leftover_tasks;
+    bool progressed = false;
+    for (uint32_t i = 0; i < lanes.size(); i++) {
+      auto &lane_tasks = lanes[i].tasks;
+      progressed |= (nums_migrated[i] > 0);
+      if (unlikely(nums_migrated[i] < lane_tasks.size())) {
+        auto dest_ip = lanes[i].dest->first.get_ip();
+        progressed |= congested_dests.insert(dest_ip).second;
+        leftover_tasks.insert(leftover_tasks.end(),
+                              lane_tasks.begin() + nums_migrated[i],
+                              lane_tasks.end());
+      }
+    }
+    leftover_tasks.insert(leftover_tasks.end(), pending_tasks.begin(),
+                          pending_tasks.end());
+    pending_tasks = std::move(leftover_tasks);
+    if (unlikely(!progressed)) {
+      break;
+    }
+  }
+
+  return tasks.size() - pending_tasks.size();
+}
+
+std::vector<Migrator::MigrationLane> Migrator::plan_migration_lanes(
+    bool mem_pressure,
+    std::vector<std::pair<ProcletMigrationTask, Resource>> *tasks,
+    const std::set<NodeIP> &congested_dests) {
+  std::vector<MigrationLane> lanes;
+  std::vector<std::pair<ProcletMigrationTask, Resource>> unplanned_tasks;
+  bool can_acquire = true;
+
+  auto acquire_lane = [&](const Resource &resource) {
+    auto acquire_start_tsc = rdtsc();
+    std::unique_ptr<std::pair<NodeGuard, Resource>> dest(
+        new std::pair<NodeGuard, Resource>(
+            get_runtime()->controller_client()->acquire_migration_dest(
+                mem_pressure, resource)));
+    tracer_.add_prologue(MigrationSpan::kAcquireNode, acquire_start_tsc,
+                         rdtsc());
+    auto dest_ip = dest->first.get_ip();
+    if (unlikely(!dest->first || congested_dests.contains(dest_ip))) {
+      can_acquire = false;
+      return false;
+    }
+    lanes.push_back(MigrationLane{.dest = std::move(dest),
+                                  .cost = cost_model_.get_params(dest_ip),
+                                  .used = {.cores = 0, .mem_mbs = 0},
+                                  .estimated_us = 0});
+    return true;
+  };
+
+  // Each proclet, in order, goes to the destination expected to be done with
+  // it first, given the proclets it has been assigned so far and its own
+  // measured migration cost.
+  for (auto &task : *tasks) {
+    std::optional<uint32_t> best_idx;
+    float best_us = 0;
+    auto consider = [&](uint32_t idx) {
+      auto &lane = lanes[idx];
+      auto used = lane.used;
+      used += task.second;
+      auto &free = lane.dest->second;
+      if (used.mem_mbs > free.mem_mbs ||
+          (!mem_pressure && used.cores > free.cores)) {
+        return;
+      }
+      auto us = lane.estimated_us + lane.cost.estimate_us(task.first.size);
+      if (!best_idx || us < best_us) {
+        best_idx = idx;
+        best_us = us;
       }
-      cur_round_tasks.push_back(tmp->first);
+    };
+
+    for (uint32_t i = 0; i < lanes.size(); i++) {
+      consider(i);
+    }
+    bool want_lane = !best_idx || best_us > kMinParallelMigrationUs;
+    if (want_lane && can_acquire && lanes.size() < kMaxNumMigrationDests &&
+        acquire_lane(task.second)) {
+      consider(lanes.size() - 1);
     }
 
-    auto delta = __migrate(dest_guard, has_mem_pressure, cur_round_tasks);
-    if (unlikely(delta < cur_round_tasks.size())) {
-      congested_dests.insert(dest_ip);
+    if (unlikely(!best_idx)) {
+      unplanned_tasks.push_back(task);
+      continue;
     }
-    it += delta;
+    auto &lane = lanes[*best_idx];
+    lane.used += task.second;
+    lane.estimated_us = best_us;
+    lane.tasks.push_back(task);
   }
 
-  return it - tasks.begin();
+  *tasks = std::move(unplanned_tasks);
+  return lanes;
 }
 
 void Migrator::pause_migrating_threads(ProcletHeader *proclet_header) {
@@ -605,63 +1385,181 @@ static inline bool receive_approval(rt::TcpConn *c) {
   return approval;
 }
 
+static inline void issue_bulk_approval(rt::TcpConn *c, uint64_t num_approved) {
+  BUG_ON(c->WriteFull(&num_approved, sizeof(num_approved), /* nt = */ false,
+                      /* poll = */ true) < 0);
+}
+
+static inline uint64_t receive_bulk_approval(rt::TcpConn *c) {
+  uint64_t num_approved;
+  BUG_ON(c->ReadFull(&num_approved, sizeof(num_approved),
+                     /* nt = */ false, /* poll = */ true) <= 0);
+  return num_approved;
+}
+
 uint32_t Migrator::__migrate(const NodeGuard &dest_guard, bool mem_pressure,
                              const std::vector<ProcletMigrationTask> &tasks) {
   if (unlikely(tasks.empty())) {
     return 0;
   }
 
+  auto record = tracer_.start_record(/* is_source = */ true,
+                                     dest_guard.get_ip());
   auto *pressure_handler = get_runtime()->pressure_handler();
   auto conn_guard = migrator_conn_mgr_.get(dest_guard.get_ip());
   auto *conn = conn_guard.get_tcp_conn();
   BUG_ON(conn->HasPendingDataToRead());
   transmit_proclet_migration_tasks(conn, mem_pressure, tasks);
 
+  // The destination approves a prefix of the tasks at once, so that the
+  // proclets can be streamed back to back, each one being transmitted while
+  // the destination is still loading the previous one.
+  uint64_t num_approved;
+  {
+    MigrationSpanGuard g(record.get(), MigrationSpan::kApprovalWait);
+    num_approved = receive_bulk_approval(conn);
+  }
+  BUG_ON(num_approved > tasks.size());
+
+  // Small proclets are gathered into batches. Their cleanups and location
+  // updates wait until their batch has been written out.
+  MigrationBatchWriter batch(conn);
+  std::vector<ProcletHeader *> batched_headers;
+  auto flush_batch = [&] {
+    batch.flush();
+    for (auto *proclet_header : batched_headers) {
+      auto id = to_proclet_id(proclet_header);
+      {
+        MigrationSpanGuard g(record.get(), MigrationSpan::kUpdateLocation, id);
+        update_proclet_location(conn, proclet_header);
+      }
+      {
+        // Held requests wait for kMigrating to be over, so it only ends once
+        // they can be given the new location.
+        ScopedLock l(&proclet_header->migration_spin());
+        proclet_header->status() = kCleaning;
+      }
+      MigrationSpanGuard g(record.get(), MigrationSpan::kCleanup, id);
+      post_migration_cleanup(proclet_header);
+    }
+    batched_headers.clear();
+  };
+
   bool aux_handlers_enabled = false;
-  auto it = tasks.begin();
-  for (; it != tasks.end(); ++it) {
-    auto *proclet_header = it->header;
-    if (unlikely(!receive_approval(conn))) {
-      break;
+  for (uint64_t i = 0; i < num_approved; i++) {
+    auto *proclet_header = tasks[i].header;
+    bool coalesce = is_coalescable(proclet_header);
+    if (!coalesce || batch.size() >= kMaxCoalescedBatchSize) {
+      flush_batch();
     }
 
     bool has_pressure = mem_pressure ? pressure_handler->has_mem_pressure()
                                      : pressure_handler->has_pressure();
-    if (unlikely(!has_pressure ||
-                 !try_mark_proclet_migrating(proclet_header))) {
+    if (unlikely(!has_pressure)) {
+      flush_batch();
       skip_proclet(conn, proclet_header);
       continue;
     }
 
-    if (unlikely(!aux_handlers_enabled)) {
-      aux_handlers_enabled = true;
-      aux_handlers_enable_polling(dest_guard.get_ip());
+    std::unique_ptr<PreCopyState> precopy_state;
+    uint64_t precopy_us = 0;
+    if (!coalesce) {
+      MigrationSpanGuard g(record.get(), MigrationSpan::kPreCopy,
+                           to_proclet_id(proclet_header));
+      auto precopy_start_us = microtime();
+      precopy_state = precopy_proclet(conn, proclet_header);
+      precopy_us = microtime() - precopy_start_us;
+    }
+    if (unlikely(!try_mark_proclet_migrating(proclet_header))) {
+      flush_batch();
+      skip_proclet(conn, proclet_header);
+      continue;
+    }
+    // The segment got reused by another proclet during pre-copy.
+    if (unlikely(precopy_state &&
+                 precopy_state->generation != proclet_header->generation)) {
+      get_runtime()->proclet_manager()->undo_remove(proclet_header);
+      skip_proclet(conn, proclet_header);
+      continue;
+    }
+
+    if (unlikely(!coalesce && !aux_handlers_enabled)) {
+      aux_handlers_enabled = aux_handlers_enable_polling(dest_guard.get_ip());
     }
 
-    pause_migrating_threads(proclet_header);
+    // The flushes of earlier batches are left out of the cost.
+    auto pause_start_us = microtime();
+    uint64_t transmitted_len;
     {
+      ScopedLock stop_copy_guard(&stop_copy_lock_);
+      {
+        MigrationSpanGuard g(record.get(), MigrationSpan::kPause,
+                             to_proclet_id(proclet_header));
+        pause_migrating_threads(proclet_header);
+      }
       ScopedLock l(&proclet_header->migration_spin());
 
-      transmit(conn, proclet_header, &all_migrating_ths);
+      transmitted_len =
+          transmit(conn, proclet_header, &all_migrating_ths,
+                   precopy_state.get(), coalesce ? &batch : nullptr,
+                   record.get());
       gc_migrated_threads();
-      proclet_header->status() = kCleaning;
+      if (!coalesce) {
+        proclet_header->status() = kCleaning;
+      }
+    }
+    // Batched proclets do not pay for their heaps here. Pre-copied ones are
+    // sampled with all their rounds, as the model is applied to whole heaps.
+    if (!coalesce) {
+      auto sent_len = transmitted_len;
+      if (precopy_state) {
+        sent_len += precopy_state->sent_len;
+      }
+      cost_model_.add_sample(dest_guard.get_ip(), sent_len,
+                             precopy_us + microtime() - pause_start_us);
+    }
+
+    if constexpr (kEnableLogging) {
+      Caladan::PreemptGuard g;
+
+      std::osyncstream synced_out(std::cout);
+      synced_out << "Pause proclet: addr = " << proclet_header
+                 << ", pause_us = " << microtime() - pause_start_us
+                 << std::endl;
+    }
+
+    precopy_state.reset();
+    if (record) {
+      record->num_proclets++;
+    }
+    if (coalesce) {
+      batched_headers.push_back(proclet_header);
+    } else {
+      MigrationSpanGuard g(record.get(), MigrationSpan::kCleanup,
+                           to_proclet_id(proclet_header));
+      post_migration_cleanup(proclet_header);
     }
-    post_migration_cleanup(proclet_header);
   }
 
+  flush_batch();
+  rt::Spawn([this] { publish_proclet_locations(); });
+
   if (aux_handlers_enabled) {
     aux_handlers_disable_polling();
   }
 
-  receive_approval(conn);
+  {
+    MigrationSpanGuard g(record.get(), MigrationSpan::kApprovalWait);
+    receive_approval(conn);
+  }
+  tracer_.finish_record(std::move(record));
 
-  return it - tasks.begin();
+  return num_approved;
 }
 
 bool Migrator::load_proclet(rt::TcpConn *c, ProcletHeader *proclet_header,
                             uint64_t capacity) {
-  constexpr bool kMonitorTime =
-      (kEnableLogging || kMigrationThrottleGBs > 0 || kMigrationDelayUs);
+  constexpr bool kMonitorTime = (kEnableLogging || kMigrationDelayUs);
   [[maybe_unused]] uint64_t t0, t1;
 
   if constexpr (kMonitorTime) {
@@ -669,23 +1567,42 @@ bool Migrator::load_proclet(rt::TcpConn *c, ProcletHeader *proclet_header,
   }
 
   uint8_t type;
-  BUG_ON(c->ReadFull(&type, sizeof(type), /* nt = */ false,
-                     /* poll = */ true) <= 0);
+  while (true) {
+    BUG_ON(c->ReadFull(&type, sizeof(type), /* nt = */ false,
+                       /* poll = */ true) <= 0);
+    if (type != kPreCopyProclet) {
+      break;
+    }
+    handle_copy_proclet_chunks(c, /* is_final = */ false);
+  }
   if (unlikely(type == kSkipProclet)) {
     return false;
   }
-  BUG_ON(type != kCopyProclet);
-  handle_copy_proclet(c);
+  uint32_t num_stripes = 0;
+  if (type == kCopyProclet) {
+    num_stripes = handle_copy_proclet(c);
+  } else {
+    BUG_ON(type != kCopyProcletDelta);
+    num_stripes = handle_copy_proclet_chunks(c, /* is_final = */ true);
+  }
 
   get_runtime()->proclet_manager()->setup(proclet_header, capacity,
                                           /* migratable = */ false,
                                           /* from_migration = */ true);
 
-  proclet_header->pending_load_cnt += kTransmitProcletNumThreads;
+  proclet_header->pending_load_cnt += num_stripes;
   while (proclet_header->pending_load_cnt.load()) {
     get_runtime()->caladan()->unblock_and_relax();
   }
 
+  // Drops whatever was populated or pre-copied into the skipped free regions.
+  auto free_regions =
+      proclet_header->slab.get_free_regions(kMinSkippedFreeRegionSize);
+  for (auto [start, end] : free_regions) {
+    BUG_ON(madvise(reinterpret_cast<void *>(start), end - start,
+                   MADV_DONTNEED) != 0);
+  }
+
   auto *slab = &proclet_header->slab;
   nu::SlabAllocator::register_slab_by_id(slab, slab->get_id());
 
@@ -693,11 +1610,6 @@ bool Migrator::load_proclet(rt::TcpConn *c, ProcletHeader *proclet_header,
     t1 = microtime();
   }
 
-  if constexpr (kMigrationThrottleGBs > 0) {
-    throttle(proclet_header->slab.get_usage(), t1 - t0);
-    t1 = microtime();
-  }
-
   if constexpr (kMigrationDelayUs) {
     auto remote_ip = c->RemoteAddr().ip;
     auto delayed = delayed_srv_ips_.contains(remote_ip);
@@ -718,21 +1630,42 @@ bool Migrator::load_proclet(rt::TcpConn *c, ProcletHeader *proclet_header,
   return true;
 }
 
-thread_t *Migrator::load_one_thread(rt::TcpConn *c,
-                                    ProcletHeader *proclet_header) {
-  size_t nu_state_size;
-  thread_get_nu_state(thread_self(), &nu_state_size);
-  auto nu_state = std::make_unique<uint8_t[]>(nu_state_size);
-  BUG_ON(c->ReadFull(nu_state.get(), nu_state_size, /* nt = */ false,
+std::vector<thread_t *> Migrator::read_threads(rt::TcpConn *c) {
+  uint64_t num_threads;
+  BUG_ON(c->ReadFull(&num_threads, sizeof(num_threads), /* nt = */ false,
                      /* poll = */ true) <= 0);
-  auto *th = thread_restore(nu_state.get());
 
-  auto stack_range = get_runtime()->get_proclet_stack_range(th);
-  auto stack_len = stack_range.end - stack_range.start;
-  BUG_ON(c->ReadFull(reinterpret_cast<void *>(stack_range.start), stack_len,
-                     /* nt = */ false,
-                     /* poll = */ true) <= 0);
-  return th;
+  std::vector<thread_t *> ths;
+  ths.reserve(num_threads);
+  if (!num_threads) {
+    return ths;
+  }
+
+  size_t nu_state_size;
+  thread_get_nu_state(thread_self(), &nu_state_size);
+  auto max_batch_size = std::min(num_threads, kThreadBatchSize);
+  auto nu_states =
+      std::make_unique_for_overwrite<uint8_t[]>(max_batch_size * nu_state_size);
+  std::vector<iovec> stack_iovecs;
+  stack_iovecs.reserve(max_batch_size);
+
+  while (ths.size() < num_threads) {
+    auto batch_size = std::min(num_threads - ths.size(), kThreadBatchSize);
+    BUG_ON(c->ReadFull(nu_states.get(), batch_size * nu_state_size,
+                       /* nt = */ false, /* poll = */ true) <= 0);
+
+    stack_iovecs.clear();
+    for (uint64_t i = 0; i < batch_size; i++) {
+      auto *th = thread_restore(nu_states.get() + i * nu_state_size);
+      ths.push_back(th);
+      auto stack_range = get_runtime()->get_proclet_stack_range(th);
+      stack_iovecs.push_back({reinterpret_cast<void *>(stack_range.start),
+                              stack_range.end - stack_range.start});
+    }
+    BUG_ON(c->ReadvFull(std::span<const iovec>(stack_iovecs),
+                        /* nt = */ false, /* poll = */ true) <= 0);
+  }
+  return ths;
 }
 
 void Migrator::load_mutexes(rt::TcpConn *c, ProcletHeader *proclet_header) {
@@ -747,15 +1680,10 @@ void Migrator::load_mutexes(rt::TcpConn *c, ProcletHeader *proclet_header) {
                        /* poll = */ true) <= 0);
 
     for (size_t i = 0; i < num_mutexes; i++) {
-      size_t num_threads;
-      BUG_ON(c->ReadFull(&num_threads, sizeof(num_threads), /* nt = */ false,
-                         /* poll = */ true) <= 0);
-
       auto *mutex = mutexes[i];
       auto *waiters = mutex->get_waiters();
       list_head_init(waiters);
-      for (size_t j = 0; j < num_threads; j++) {
-        auto *th = load_one_thread(c, proclet_header);
+      for (auto *th : read_threads(c)) {
         auto *th_link = reinterpret_cast<list_node *>(
             reinterpret_cast<uintptr_t>(th) + thread_link_offset);
         list_add_tail(waiters, th_link);
@@ -776,15 +1704,10 @@ void Migrator::load_condvars(rt::TcpConn *c, ProcletHeader *proclet_header) {
                        /* poll = */ true) <= 0);
 
     for (size_t i = 0; i < num_condvars; i++) {
-      size_t num_threads;
-      BUG_ON(c->ReadFull(&num_threads, sizeof(num_threads), /* nt = */ false,
-                         /* poll = */ true) <= 0);
-
       auto *condvar = condvars[i];
       auto *waiters = condvar->get_waiters();
       list_head_init(waiters);
-      for (size_t j = 0; j < num_threads; j++) {
-        auto *th = load_one_thread(c, proclet_header);
+      for (auto *th : read_threads(c)) {
         auto *th_link = reinterpret_cast<list_node *>(
             reinterpret_cast<uintptr_t>(th) + thread_link_offset);
         list_add_tail(waiters, th_link);
@@ -814,11 +1737,12 @@ void Migrator::load_time_and_mark_proclet_present(
                        /* nt = */ false,
                        /* poll = */ true) <= 0);
 
+    auto ths = read_threads(c);
+    BUG_ON(ths.size() != num_entries);
     for (size_t i = 0; i < num_entries; i++) {
       auto *entry = timer_entries[i];
       auto *arg = reinterpret_cast<TimerCallbackArg *>(entry->arg);
-      auto *th = load_one_thread(c, proclet_header);
-      arg->th = th;
+      arg->th = ths[i];
       entry->armed = false;
       timer_start(entry, time.to_physical_us(arg->logical_deadline_us));
     }
@@ -826,14 +1750,8 @@ void Migrator::load_time_and_mark_proclet_present(
 }
 
 void Migrator::load_threads(rt::TcpConn *c, ProcletHeader *proclet_header) {
-  uint64_t num_threads;
-  BUG_ON(c->ReadFull(&num_threads, sizeof(num_threads), /* nt = */ false,
-                     /* poll = */ true) <= 0);
-
-  for (uint64_t i = 0; i < num_threads; i++) {
-    auto *th = load_one_thread(c, proclet_header);
-    threads_to_wakeup_.push_back(th);
-  }
+  auto ths = read_threads(c);
+  threads_to_wakeup_.insert(threads_to_wakeup_.end(), ths.begin(), ths.end());
 }
 
 std::pair<bool, std::vector<ProcletMigrationTask>>
@@ -857,7 +1775,17 @@ Migrator::load_proclet_migration_tasks(rt::TcpConn *c) {
 }
 
 void Migrator::populate_proclets(std::vector<ProcletMigrationTask> &tasks) {
-  for (auto &[header, _0, size, _1] : tasks) {
+  static_assert(kPopulateChunkSize % ProcletManager::kHugePageSize == 0);
+
+  struct PopulateChunk {
+    ProcletHeader *header;
+    uint64_t offset;
+    uint64_t len;
+  };
+  // The chunks follow the order in which the heaps are going to arrive.
+  auto chunks = std::make_shared<std::vector<PopulateChunk>>();
+
+  for (auto &[header, capacity, size, _] : tasks) {
     ScopedLock l(&header->migration_spin());
 
     if (unlikely(header->status() == kCleaning)) {
@@ -865,39 +1793,77 @@ void Migrator::populate_proclets(std::vector<ProcletMigrationTask> &tasks) {
     }
     header->status() = kPopulating;
     header->populate_size = size;
+    header->capacity = capacity;
+    if (size >= ProcletManager::kMinHugePageHeapSize) {
+      ProcletManager::madvise_huge_pages(header, capacity,
+                                         /* enable = */ true);
+    }
+    for (uint64_t offset = 0; offset < size; offset += kPopulateChunkSize) {
+      chunks->push_back(
+          {header, offset, std::min(kPopulateChunkSize, size - offset)});
+    }
   }
 
-  rt::Spawn([tasks] {
-    for (auto &[header, _0, size, _1] : tasks) {
-      if (load_acquire(&header->status()) == kPopulating) {
+  auto next_chunk = std::make_shared<std::atomic<uint64_t>>(0);
+  auto populate = [chunks, next_chunk] {
+    while (true) {
+      auto idx = next_chunk->fetch_add(1);
+      if (idx >= chunks->size()) {
+        break;
+      }
+      auto [header, offset, len] = (*chunks)[idx];
+      if (unlikely(get_runtime()->pressure_handler()->has_mem_pressure())) {
+        // Leaves the remaining chunks to nobody.
+        next_chunk->store(chunks->size());
+        break;
+      }
+      if (load_acquire(&header->status()) != kPopulating ||
+          get_runtime()->resource_reporter()->get_usable_mem_mbs() <=
+              len / kOneMB) {
+        continue;
+      }
+      {
         ScopedLock l(&header->migration_spin());
 
-        if (likely(header->status() == kPopulating)) {
-          if (unlikely(get_runtime()->pressure_handler()->has_mem_pressure())) {
-            break;
-          }
-          if (get_runtime()->resource_reporter()->get_usable_mem_mbs() >
-              size / kOneMB) {
-            get_runtime()->proclet_manager()->madvise_populate(header, size);
-          }
+        if (unlikely(header->status() != kPopulating)) {
+          continue;
         }
+        header->num_populators++;
       }
+      get_runtime()->proclet_manager()->madvise_populate(
+          reinterpret_cast<uint8_t *>(header) + offset, len);
+      header->num_populators--;
     }
-  });
+  };
+
+  auto num_threads =
+      std::min<uint64_t>(kMaxNumPopulateThreads, chunks->size());
+  for (uint64_t i = 0; i < num_threads; i++) {
+    rt::Spawn(populate);
+  }
 }
 
 void Migrator::depopulate_proclet(ProcletHeader *proclet_header) {
   proclet_header->status() = kDepopulating;
   mb();
+  notify_loaded();
 
   rt::Spawn([proclet_header] {
     if (load_acquire(&proclet_header->status()) == kDepopulating) {
-      ScopedLock l(&proclet_header->migration_spin());
+      {
+        // Populators that saw kPopulating have registered once it is taken.
+        ScopedLock l(&proclet_header->migration_spin());
+      }
+      wait_for_populators(proclet_header);
 
+      ScopedLock l(&proclet_header->migration_spin());
       if (likely(proclet_header->status() == kDepopulating)) {
+        auto capacity = proclet_header->capacity;
         get_runtime()->proclet_manager()->depopulate(
             proclet_header, proclet_header->populate_size,
             /* defer = */ false);
+        ProcletManager::madvise_huge_pages(proclet_header, capacity,
+                                           /* enable = */ false);
         proclet_header->status() = kAbsent;
       }
     }
@@ -905,44 +1871,74 @@ void Migrator::depopulate_proclet(ProcletHeader *proclet_header) {
 }
 
 void Migrator::load(rt::TcpConn *c) {
+  auto record = tracer_.start_record(/* is_source = */ false,
+                                     c->RemoteAddr().ip);
   auto [remote_mem_pressure, tasks] = load_proclet_migration_tasks(c);
-  populate_proclets(tasks);
+  {
+    MigrationSpanGuard g(record.get(), MigrationSpan::kPopulate);
+    populate_proclets(tasks);
+  }
 
+  // Approves the longest prefix of the tasks that fits in the local
+  // resources altogether.
   auto local_free_cores = get_runtime()->resource_reporter()->get_free_cores();
-  bool approval = true;
-  for (auto it = tasks.begin(); it != tasks.end(); ++it) {
-    auto local_mem_pressure =
-        get_runtime()->resource_reporter()->get_usable_mem_mbs() <
-        it->size / kOneMB;
-    auto local_cpu_pressure =
-        get_runtime()->pressure_handler()->has_cpu_pressure() ||
-        (local_free_cores <= it->cores);
-    approval = remote_mem_pressure
-                   ? (!local_mem_pressure)
-                   : (!local_mem_pressure && !local_cpu_pressure);
-    if (approval) {
-      local_free_cores -= it->cores;
-    }
-    issue_approval(c, approval);
-
-    if (unlikely(!approval)) {
-      for (; it != tasks.end(); ++it) {
-        depopulate_proclet(it->header);
-      }
+  auto local_usable_mem_mbs =
+      get_runtime()->resource_reporter()->get_usable_mem_mbs();
+  auto local_cpu_pressure =
+      get_runtime()->pressure_handler()->has_cpu_pressure();
+  uint64_t num_approved = 0;
+  for (auto &task : tasks) {
+    auto mem_mbs = task.size / kOneMB;
+    auto local_mem_pressure = local_usable_mem_mbs < mem_mbs;
+    auto approval = remote_mem_pressure
+                        ? (!local_mem_pressure)
+                        : (!local_mem_pressure && !local_cpu_pressure &&
+                           local_free_cores > task.cores);
+    if (!approval) {
       break;
     }
+    local_usable_mem_mbs -= mem_mbs;
+    local_free_cores -= task.cores;
+    num_approved++;
+  }
+  issue_bulk_approval(c, num_approved);
+  for (auto it = tasks.begin() + num_approved; it != tasks.end(); ++it) {
+    depopulate_proclet(it->header);
+  }
 
+  for (auto it = tasks.begin(); it != tasks.begin() + num_approved; ++it) {
     auto &[proclet_header, capacity, _0, _1] = *it;
-    if (unlikely(!load_proclet(c, proclet_header, capacity))) {
+    auto id = to_proclet_id(proclet_header);
+    bool loaded;
+    {
+      MigrationSpanGuard g(record.get(), MigrationSpan::kLoadHeap, id);
+      loaded = load_proclet(c, proclet_header, capacity);
+    }
+    if (unlikely(!loaded)) {
       depopulate_proclet(proclet_header);
       continue;
     }
+    if (record) {
+      record->num_proclets++;
+    }
 
-    load_mutexes(c, proclet_header);
-    load_condvars(c, proclet_header);
-    load_threads(c, proclet_header);
+    {
+      MigrationSpanGuard g(record.get(), MigrationSpan::kLoadMutexes, id);
+      load_mutexes(c, proclet_header);
+    }
+    {
+      MigrationSpanGuard g(record.get(), MigrationSpan::kLoadCondVars, id);
+      load_condvars(c, proclet_header);
+    }
+    {
+      MigrationSpanGuard g(record.get(), MigrationSpan::kLoadThreads, id);
+      load_threads(c, proclet_header);
+    }
     // Now all stacks have been loaded, safe to resume threads.
-    load_time_and_mark_proclet_present(c, proclet_header);
+    {
+      MigrationSpanGuard g(record.get(), MigrationSpan::kLoadTime, id);
+      load_time_and_mark_proclet_present(c, proclet_header);
+    }
     for (auto *th : threads_to_wakeup_) {
       thread_ready(th);
     }
@@ -950,10 +1946,12 @@ void Migrator::load(rt::TcpConn *c) {
 
     // Wakeup the blocked threads.
     proclet_header->cond_var.signal_all();
+    notify_loaded();
     proclet_header->migratable = true;
   }
 
   issue_approval(c, true);
+  tracer_.finish_record(std::move(record));
 }
 
 void Migrator::reserve_conns(uint32_t dest_server_ip) {
@@ -1022,7 +2020,8 @@ retry:
   auto rc = rpc_client->Call(req_span, &unused_buf);
 
   if (unlikely(rc == kErrWrongClient)) {
-    get_runtime()->rpc_client_mgr()->invalidate_cache(dest_id, rpc_client);
+    get_runtime()->rpc_client_mgr()->invalidate_cache(dest_id, rpc_client,
+                                                      unused_buf);
     goto retry;
   }
 
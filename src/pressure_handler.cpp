@@ -3,6 +3,7 @@
 #include <sync.h>
 #include <thread.h>
 
+#include <algorithm>
 #include <iostream>
 #include <limits>
 #include <type_traits>
@@ -20,6 +21,12 @@ namespace nu {
 
 PressureHandler::PressureHandler()
     : active_handlers_{0}, mock_(false), done_(false) {
+  // Each aux handler occupies a core and a migration connection while
+  // handling pressure.
+  auto max_cores = rt::RuntimeMaxCores();
+  num_aux_handlers_ = std::min(
+      {kMaxNumAuxHandlers, Migrator::kDefaultNumReservedConns - 1,
+       max_cores > 2 ? max_cores - 2 : 1});
   register_handlers();
 
   update_th_ = rt::Thread([&] {
@@ -53,9 +60,11 @@ PressureHandler::~PressureHandler() {
 Utility::Utility() {}
 
 Utility::Utility(ProcletHeader *proclet_header, uint64_t mem_size,
-                 float cpu_load) {
+                 float cpu_load, bool latency_critical,
+                 const MigrationCostModel::Params &cost)
+    : latency_critical(latency_critical) {
   header = proclet_header;
-  auto time = kFixedCostUs + (mem_size / (kNetBwGbps / 8.0f) / 1000.0f);
+  auto time = cost.estimate_us(mem_size);
 
   cpu_pressure_util = cpu_load / time;
   mem_pressure_util = mem_size / time;
@@ -66,23 +75,56 @@ void PressureHandler::update_sorted_proclets() {
       std::make_shared<decltype(mem_pressure_sorted_proclets_)::element_type>();
   auto new_cpu_pressure_sorted_proclets =
       std::make_shared<decltype(cpu_pressure_sorted_proclets_)::element_type>();
+  auto new_cold_sorted_proclets =
+      std::make_shared<decltype(cold_sorted_proclets_)::element_type>();
+  decltype(idle_states_) new_idle_states;
   auto all_proclets = get_runtime()->proclet_manager()->get_all_proclets();
+  auto cost = get_runtime()->migrator()->cost_model()->get_params();
+  auto can_spill = get_runtime()->proclet_manager()->can_spill();
+  auto now_us = microtime();
 
   auto used_budget = 0;
   for (auto *proclet_base : all_proclets) {
     auto *proclet_header = reinterpret_cast<ProcletHeader *>(proclet_base);
     auto optional_info = get_runtime()->proclet_manager()->get_proclet_info(
-        proclet_header, std::function([](const ProcletHeader *header) {
+        proclet_header,
+        std::function([proclet_header](const ProcletHeader *header) {
+          auto num_high_priority_calls =
+              proclet_header->num_high_priority_calls.exchange(
+                  0, std::memory_order_relaxed);
           return std::make_tuple(header->migratable, header->total_mem_size(),
-                                 header->cpu_load.get_load());
+                                 header->cpu_load.get_load(),
+                                 num_high_priority_calls > 0,
+                                 header->generation,
+                                 header->cpu_load.get_num_invocations());
         }));
 
     if (likely(optional_info)) {
-      auto [migratable, mem_size, cpu_load] = *optional_info;
+      auto [migratable, mem_size, cpu_load, latency_critical, generation,
+            num_invocations] = *optional_info;
       if (migratable) {
-        Utility u(proclet_header, mem_size, cpu_load);
+        Utility u(proclet_header, mem_size, cpu_load, latency_critical, cost);
         new_cpu_pressure_sorted_proclets->insert(u);
         new_mem_pressure_sorted_proclets->insert(u);
+
+        auto &idle_state = new_idle_states[proclet_header];
+        auto iter = idle_states_.find(proclet_header);
+        if (iter != idle_states_.end() &&
+            iter->second.generation == generation &&
+            iter->second.num_invocations == num_invocations) {
+          idle_state = iter->second;
+        } else {
+          idle_state = IdleState{.generation = generation,
+                                 .num_invocations = num_invocations,
+                                 .since_us = now_us};
+        }
+        auto idle_us = now_us - idle_state.since_us;
+        if (can_spill && !latency_critical && idle_us >= kMinSpillIdleUs &&
+            mem_size >= kMinSpillMemSize) {
+          new_cold_sorted_proclets->insert(ColdProclet{
+              .header = proclet_header, .idle_us = idle_us,
+              .cpu_load = cpu_load});
+        }
       }
     }
 
@@ -99,16 +141,18 @@ void PressureHandler::update_sorted_proclets() {
                          new_cpu_pressure_sorted_proclets);
     std::atomic_exchange(&mem_pressure_sorted_proclets_,
                          new_mem_pressure_sorted_proclets);
+    std::atomic_exchange(&cold_sorted_proclets_, new_cold_sorted_proclets);
   }
+  idle_states_ = std::move(new_idle_states);
 }
 
 void PressureHandler::register_handlers() {
-  resource_pressure_closure closures[kNumAuxHandlers + 1];
+  resource_pressure_closure closures[kMaxNumAuxHandlers + 1];
   closures[0] = {main_handler, nullptr};
-  for (uint32_t i = 1; i < kNumAuxHandlers + 1; i++) {
+  for (uint32_t i = 1; i < num_aux_handlers_ + 1; i++) {
     closures[i] = {aux_handler, &aux_handler_states_[i - 1]};
   }
-  create_resource_pressure_handlers(closures, kNumAuxHandlers + 1);
+  create_resource_pressure_handlers(closures, num_aux_handlers_ + 1);
 }
 
 void PressureHandler::main_handler(void *unused) {
@@ -116,12 +160,15 @@ void PressureHandler::main_handler(void *unused) {
 }
 
 void PressureHandler::__main_handler() {
-  active_handlers_ += kNumAuxHandlers + 1;
+  active_handlers_ += num_aux_handlers_ + 1;
 
+  auto acquire_start_tsc = rdtsc();
   auto node_guard = get_runtime()->controller_client()->acquire_node();
   if (unlikely(!node_guard)) {
     goto done;
   }
+  get_runtime()->migrator()->tracer()->add_prologue(
+      MigrationSpan::kAcquireNode, acquire_start_tsc, rdtsc());
 
   while (has_pressure()) {
     if constexpr (kEnableLogging) {
@@ -134,13 +181,20 @@ void PressureHandler::__main_handler() {
     auto min_num_proclets =
         has_cpu_pressure() ? kMinNumProcletsOnCPUPressure : 0;
     auto min_mem_mbs = rt::RuntimeToReleaseMemMbs();
+    auto pick_start_tsc = rdtsc();
     auto picked_tasks = pick_tasks(min_num_proclets, min_mem_mbs);
+    get_runtime()->migrator()->tracer()->add_prologue(
+        MigrationSpan::kPickTasks, pick_start_tsc, rdtsc());
     if (likely(!picked_tasks.empty())) {
       auto num_migrated = get_runtime()->migrator()->migrate(picked_tasks);
       if constexpr (kEnableLogging) {
         std::cout << "Migrate " << num_migrated << " proclets." << std::endl;
       }
       if (unlikely(num_migrated != picked_tasks.size())) {
+        // No other node could take the rest.
+        if (has_mem_pressure()) {
+          spill_cold_proclets(rt::RuntimeToReleaseMemMbs());
+        }
         break;
       }
     } else {
@@ -160,13 +214,13 @@ done:
 
 void PressureHandler::pause_aux_handlers() {
   // Pause aux pressure handlers.
-  for (uint32_t i = 0; i < PressureHandler::kNumAuxHandlers; i++) {
+  for (uint32_t i = 0; i < num_aux_handlers_; i++) {
     rt::access_once(aux_handler_states_[i].done) = true;
   }
 }
 
 void PressureHandler::wait_aux_tasks() {
-  for (uint32_t i = 0; i < kNumAuxHandlers; i++) {
+  for (uint32_t i = 0; i < num_aux_handlers_; i++) {
     while (rt::access_once(aux_handler_states_[i].task_pending)) {
       get_runtime()->caladan()->unblock_and_relax();
     }
@@ -211,9 +265,10 @@ void PressureHandler::__aux_handler(AuxHandlerState *state) {
         store_release(&state->pause, false);
       } else {
         auto *c = state->conn.get_tcp_conn();
-        BUG_ON(c->WritevFull(std::span<const iovec>(state->tcp_write_task),
-                             /* nt = */ true,
-                             /* poll = */ true) < 0);
+        state->task_start_tsc = rdtsc();
+        get_runtime()->migrator()->transmit_budgeted(
+            c, state->tcp_write_task, /* nt = */ true);
+        state->task_end_tsc = rdtsc();
       }
       store_release(&state->task_pending, false);
     }
@@ -311,6 +366,44 @@ PressureHandler::pick_tasks(uint32_t min_num_proclets, uint32_t min_mem_mbs) {
   return picked_tasks;
 }
 
+void PressureHandler::spill_cold_proclets(uint32_t min_mem_mbs) {
+  auto *proclet_manager = get_runtime()->proclet_manager();
+  if (!proclet_manager->can_spill()) {
+    return;
+  }
+
+  auto cold_proclets = std::atomic_load(&cold_sorted_proclets_);
+  if (!cold_proclets) {
+    return;
+  }
+
+  // Spilling blocks on file I/O, which the handler must not do itself.
+  uint32_t num_spilled = 0;
+  uint64_t spilled_mem_size = 0;
+  std::atomic<bool> done = false;
+  rt::Spawn([&] {
+    for (auto &cold_proclet : *cold_proclets) {
+      if (spilled_mem_size >= min_mem_mbs * kOneMB || !has_mem_pressure()) {
+        break;
+      }
+      auto mem_size = cold_proclet.header->total_mem_size();
+      if (proclet_manager->spill(cold_proclet.header)) {
+        num_spilled++;
+        spilled_mem_size += mem_size;
+      }
+    }
+    done = true;
+  });
+  while (!done.load()) {
+    get_runtime()->caladan()->unblock_and_relax();
+  }
+
+  if constexpr (kEnableLogging) {
+    std::cout << "Spill " << num_spilled << " proclets, "
+              << spilled_mem_size / kOneMB << " MB." << std::endl;
+  }
+}
+
 void PressureHandler::mock_set_pressure() {
   mock_ = true;
   store_release(&resource_pressure_info->mock, true);
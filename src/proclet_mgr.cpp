@@ -1,25 +1,41 @@
 #include <asm/mman.h>
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdint>
+#include <filesystem>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 extern "C" {
 #include <base/assert.h>
 #include <runtime/thread.h>
+#include <runtime/timer.h>
 }
+#include <thread.h>
 
-#include "nu/runtime.hpp"
+#include "nu/ctrl_client.hpp"
+#include "nu/migrator.hpp"
 #include "nu/proclet_mgr.hpp"
+#include "nu/runtime.hpp"
+#include "nu/utils/scoped_lock.hpp"
 
 namespace nu {
 
 uint8_t proclet_statuses[kMaxNumProclets];
 SpinLock proclet_migration_spin[kMaxNumProclets];
+ProcletLocation proclet_forward_locations[kMaxNumProclets];
 
 ProcletManager::ProcletManager() {
   num_present_proclets_ = 0;
+  checkpoint_tracking_ = false;
   for (uint64_t vaddr = kMinProcletHeapVAddr;
        vaddr + kMaxProcletHeapSize <= kMaxProcletHeapVAddr;
        vaddr += kMaxProcletHeapSize) {
@@ -31,6 +47,15 @@ ProcletManager::ProcletManager() {
     auto rc = madvise(proclet_base, kMaxProcletHeapSize, MADV_DONTDUMP);
     BUG_ON(rc == -1);
   }
+  for (auto &pool : warm_heap_pools_) {
+    pool.heaps.reserve(kWarmHeapPoolSize);
+  }
+}
+
+ProcletManager::~ProcletManager() {
+  for (auto *proclet_base : spilled_proclets_) {
+    unlink(get_spill_path(proclet_base).c_str());
+  }
 }
 
 void ProcletManager::madvise_populate(void *proclet_base,
@@ -39,7 +64,17 @@ void ProcletManager::madvise_populate(void *proclet_base,
   madvise(proclet_base, populate_len, MADV_POPULATE_WRITE);
 }
 
-void ProcletManager::cleanup(void *proclet_base, bool for_migration) {
+void ProcletManager::madvise_huge_pages(void *proclet_base, uint64_t capacity,
+                                        bool enable) {
+  static_assert(kMinProcletHeapSize % kHugePageSize == 0);
+  if constexpr (kEnableHugePageHeaps) {
+    BUG_ON(madvise(proclet_base, capacity,
+                   enable ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) != 0);
+  }
+}
+
+void ProcletManager::cleanup(void *proclet_base, bool for_migration,
+                             bool for_recycling) {
   RuntimeSlabGuard guard;
   auto *proclet_header = reinterpret_cast<ProcletHeader *>(proclet_base);
 
@@ -52,12 +87,139 @@ void ProcletManager::cleanup(void *proclet_base, bool for_migration) {
   // Deregister its slab ID.
   std::destroy_at(&proclet_header->slab);
 
-  bool defer = !for_migration;
-  depopulate(proclet_base, proclet_header->heap_size(), defer);
+  if (!for_migration) {
+    proclet_header->forward_location().raw = 0;
+  }
+
+  auto heap_size = proclet_header->heap_size();
+  if (for_recycling) {
+    // Keep the warm prefix populated for the next proclet.
+    if (heap_size > kWarmHeapPopulateSize) {
+      depopulate(reinterpret_cast<uint8_t *>(proclet_base) +
+                     kWarmHeapPopulateSize,
+                 heap_size - kWarmHeapPopulateSize, /* defer = */ true);
+    }
+  } else {
+    bool defer = !for_migration;
+    auto capacity = proclet_header->capacity;
+    depopulate(proclet_base, heap_size, defer);
+    madvise_huge_pages(proclet_base, capacity, /* enable = */ false);
+  }
 
   proclet_header->status() = kAbsent;
 }
 
+void ProcletManager::destroy(void *proclet_base) {
+  auto *proclet_header = reinterpret_cast<ProcletHeader *>(proclet_base);
+  auto range = proclet_header->range();
+  auto capacity = proclet_header->capacity;
+
+  if (!checkpoint_dir_.empty()) {
+    // So that the proclet does not come back on the next restore.
+    unlink(get_checkpoint_path(to_proclet_id(proclet_base)).c_str());
+    rt::MutexGuard g(&spill_mutex_);
+    if (checkpoint_states_.erase(proclet_header) &&
+        checkpoint_states_.empty()) {
+      checkpoint_tracker_.stop();
+      checkpoint_tracking_ = false;
+    }
+  }
+
+  if (capacity <= kMaxWarmProcletHeapSize) {
+    auto &pool = get_warm_heap_pool(capacity);
+    bool has_room;
+    {
+      ScopedLock lock(&pool.spin);
+      has_room = pool.heaps.size() < kWarmHeapPoolSize;
+    }
+
+    if (has_room) {
+      cleanup(proclet_base, /* for_migration = */ false,
+              /* for_recycling = */ true);
+      ScopedLock lock(&pool.spin);
+      if (likely(pool.heaps.size() < kWarmHeapPoolSize)) {
+        pool.heaps.push_back(ProcletAllocation{
+            .id = to_proclet_id(proclet_base),
+            .ip = get_cfg_ip(),
+            .generation = proclet_header->location_generation});
+        return;
+      }
+    } else {
+      cleanup(proclet_base, /* for_migration = */ false);
+    }
+  } else {
+    cleanup(proclet_base, /* for_migration = */ false);
+  }
+
+  get_runtime()->controller_client()->destroy_proclet(range);
+}
+
+ProcletManager::WarmHeapPool &ProcletManager::get_warm_heap_pool(
+    uint64_t capacity) {
+  return warm_heap_pools_[bsr_64(capacity) - bsr_64(kMinProcletHeapSize)];
+}
+
+std::optional<ProcletAllocation> ProcletManager::acquire_warm_heap(
+    uint64_t capacity) {
+  if (capacity > kMaxWarmProcletHeapSize) {
+    return std::nullopt;
+  }
+
+  auto &pool = get_warm_heap_pool(capacity);
+  std::optional<ProcletAllocation> heap;
+  bool refill;
+  {
+    ScopedLock lock(&pool.spin);
+    if (!pool.heaps.empty()) {
+      heap = pool.heaps.back();
+      pool.heaps.pop_back();
+    }
+    refill = !pool.refilling && pool.heaps.size() < kWarmHeapPoolLowWatermark;
+    pool.refilling |= refill;
+  }
+
+  if (refill) {
+    rt::Spawn([this, capacity] { refill_warm_heap_pool(capacity); });
+  }
+  return heap;
+}
+
+void ProcletManager::refill_warm_heap_pool(uint64_t capacity) {
+  RuntimeSlabGuard guard;
+  auto &pool = get_warm_heap_pool(capacity);
+
+  uint32_t num;
+  {
+    ScopedLock lock(&pool.spin);
+    num = kWarmHeapPoolSize - pool.heaps.size();
+  }
+
+  auto allocated = get_runtime()->controller_client()->allocate_proclets(
+      capacity, get_cfg_ip(), num);
+  for (auto &heap : allocated) {
+    madvise_populate(to_proclet_base(heap.id), kWarmHeapPopulateSize);
+  }
+
+  std::vector<ProcletID> surplus;
+  {
+    ScopedLock lock(&pool.spin);
+    for (auto &heap : allocated) {
+      if (pool.heaps.size() < kWarmHeapPoolSize) {
+        pool.heaps.push_back(heap);
+      } else {
+        surplus.push_back(heap.id);
+      }
+    }
+    pool.refilling = false;
+  }
+
+  for (auto id : surplus) {
+    depopulate(to_proclet_base(id), kWarmHeapPopulateSize, /* defer = */ false);
+    get_runtime()->controller_client()->destroy_proclet(
+        VAddrRange{.start = id, .end = id + capacity});
+  }
+}
+
 void ProcletManager::depopulate(void *proclet_base, uint64_t size, bool defer) {
   size = ((size - 1) / kPageSize + 1) * kPageSize;
 
@@ -74,15 +236,18 @@ void ProcletManager::depopulate(void *proclet_base, uint64_t size, bool defer) {
 }
 
 void ProcletManager::setup(void *proclet_base, uint64_t capacity,
-                           bool migratable, bool from_migration) {
+                           bool migratable, bool from_migration,
+                           uint32_t location_generation) {
   RuntimeSlabGuard rg;
   auto *proclet_header = reinterpret_cast<ProcletHeader *>(proclet_base);
 
   proclet_header->capacity = capacity;
   std::construct_at(&proclet_header->cpu_load);
+  std::construct_at(&proclet_header->num_high_priority_calls, 0);
   std::construct_at(&proclet_header->spin_lock);
   std::construct_at(&proclet_header->cond_var);
   proclet_header->migratable = migratable;
+  proclet_header->generation++;
 
   if (!from_migration) {
     auto slab_region_size = capacity - sizeof(ProcletHeader);
@@ -94,6 +259,13 @@ void ProcletManager::setup(void *proclet_base, uint64_t capacity,
     std::construct_at(&proclet_header->time);
     std::construct_at(&proclet_header->rcu_lock);
     proclet_header->ref_cnt = 1;
+    std::construct_at(&proclet_header->callers);
+    std::construct_at(&proclet_header->invocation_stats, nullptr);
+    if (proclet_header->location_generation != location_generation ||
+        !proclet_header->location_epoch) {
+      proclet_header->location_generation = location_generation;
+      proclet_header->location_epoch = 1;
+    }
     std::construct_at(&proclet_header->slab_ref_cnt);
   }
 }
@@ -126,4 +298,419 @@ uint64_t ProcletManager::get_mem_usage() {
   return total_mem_usage;
 }
 
+void ProcletManager::set_spill_dir(std::string dir) {
+  spill_dir_ = std::move(dir);
+}
+
+std::string ProcletManager::get_spill_path(void *proclet_base) const {
+  auto *proclet_header = reinterpret_cast<ProcletHeader *>(proclet_base);
+  return spill_dir_ + "/nu_" + std::to_string(getpid()) + "_" +
+         std::to_string(proclet_header->global_idx()) + ".spill";
+}
+
+uint32_t ProcletManager::get_num_spilled_proclets() {
+  rt::MutexGuard g(&spill_mutex_);
+  return spilled_proclets_.size();
+}
+
+static bool write_full(int fd, const void *buf, uint64_t len) {
+  auto *p = reinterpret_cast<const uint8_t *>(buf);
+  while (len) {
+    auto ret = write(fd, p, len);
+    if (unlikely(ret <= 0)) {
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += ret;
+    len -= ret;
+  }
+  return true;
+}
+
+static bool read_full(int fd, void *buf, uint64_t len) {
+  auto *p = reinterpret_cast<uint8_t *>(buf);
+  while (len) {
+    auto ret = read(fd, p, len);
+    if (unlikely(ret <= 0)) {
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    p += ret;
+    len -= ret;
+  }
+  return true;
+}
+
+// Invocations arriving from now on wait in reload() until the proclet is
+// back. Only proclets that nothing runs in, waits in or is scheduled for get
+// paused.
+bool ProcletManager::pause_if_idle(ProcletHeader *proclet_header) {
+  {
+    ScopedLock lock(&spin_);
+    if (!proclet_header->migratable || !__remove(proclet_header, kSpilled)) {
+      return false;
+    }
+    std::erase(present_proclets_, proclet_header);
+  }
+
+  bool idle = proclet_header->rcu_lock.writer_sync(
+                  /* poll = */ true, Migrator::kRCUWaitTimeoutUs) &&
+              !proclet_header->thread_cnt.get() &&
+              !proclet_header->slab_ref_cnt.get() &&
+              proclet_header->time.entries_.empty() &&
+              proclet_header->blocked_syncer.get_all().empty();
+  if (unlikely(!idle)) {
+    restore_spilled(proclet_header);
+  }
+  return idle;
+}
+
+bool ProcletManager::spill(void *proclet_base) {
+  if (!can_spill()) {
+    return false;
+  }
+
+  RuntimeSlabGuard guard;
+  auto *proclet_header = reinterpret_cast<ProcletHeader *>(proclet_base);
+  rt::MutexGuard g(&spill_mutex_);
+
+  if (!pause_if_idle(proclet_header)) {
+    return false;
+  }
+
+  // The header stays resident, as it is needed while the proclet is away.
+  auto start_addr =
+      reinterpret_cast<uint64_t>(proclet_header->slab.get_base());
+  auto end_addr = start_addr + proclet_header->slab.get_usage();
+  start_addr = (start_addr + kPageSize - 1) / kPageSize * kPageSize;
+  end_addr = (end_addr + kPageSize - 1) / kPageSize * kPageSize;
+  VAddrRange range{.start = start_addr, .end = end_addr};
+
+  if (unlikely(start_addr >= end_addr ||
+               !write_spill_file(proclet_header, range))) {
+    restore_spilled(proclet_base);
+    return false;
+  }
+  BUG_ON(madvise(reinterpret_cast<void *>(start_addr), end_addr - start_addr,
+                 MADV_DONTNEED) != 0);
+  spilled_proclets_.insert(proclet_base);
+  return true;
+}
+
+// Splits the sorted ranges around the free slab regions, which carry no data.
+static std::vector<VAddrRange> get_live_chunks(
+    ProcletHeader *proclet_header, const std::vector<VAddrRange> &ranges) {
+  auto free_regions = proclet_header->slab.get_free_regions(
+      Migrator::kMinSkippedFreeRegionSize);
+  std::vector<VAddrRange> chunks;
+  auto iter = free_regions.begin();
+  for (auto [addr, end] : ranges) {
+    while (addr < end) {
+      while (iter != free_regions.end() && iter->end <= addr) {
+        ++iter;
+      }
+      if (iter != free_regions.end() && iter->start <= addr) {
+        addr = std::min(end, iter->end);
+        continue;
+      }
+      auto live_end =
+          (iter == free_regions.end()) ? end : std::min(end, iter->start);
+      chunks.push_back(VAddrRange{.start = addr, .end = live_end});
+      addr = live_end;
+    }
+  }
+  return chunks;
+}
+
+// Uses the layout of the migration chunk messages: the number of chunks,
+// their address ranges and then their data.
+static bool write_chunks(int fd, const std::vector<VAddrRange> &chunks) {
+  uint64_t num_chunks = chunks.size();
+  bool written = write_full(fd, &num_chunks, sizeof(num_chunks)) &&
+                 write_full(fd, chunks.data(),
+                            num_chunks * sizeof(VAddrRange));
+  for (auto [chunk_start, chunk_end] : chunks) {
+    written = written &&
+              write_full(fd, reinterpret_cast<const void *>(chunk_start),
+                         chunk_end - chunk_start);
+  }
+  return written;
+}
+
+// Copies the chunks back in place. Nothing is copied if the file ends before
+// the last chunk does.
+static bool read_chunks(int fd) {
+  struct stat st;
+  auto offset = lseek(fd, 0, SEEK_CUR);
+  uint64_t num_chunks;
+  if (unlikely(fstat(fd, &st) != 0 || offset < 0 ||
+               !read_full(fd, &num_chunks, sizeof(num_chunks)))) {
+    return false;
+  }
+  uint64_t remaining = st.st_size - offset - sizeof(num_chunks);
+  if (unlikely(num_chunks > remaining / sizeof(VAddrRange))) {
+    return false;
+  }
+  std::vector<VAddrRange> chunks(num_chunks);
+  if (unlikely(!read_full(fd, chunks.data(),
+                          num_chunks * sizeof(VAddrRange)))) {
+    return false;
+  }
+  remaining -= num_chunks * sizeof(VAddrRange);
+
+  uint64_t len = 0;
+  for (auto [chunk_start, chunk_end] : chunks) {
+    len += chunk_end - chunk_start;
+  }
+  if (unlikely(len > remaining)) {
+    return false;
+  }
+  for (auto [chunk_start, chunk_end] : chunks) {
+    if (unlikely(!read_full(fd, reinterpret_cast<void *>(chunk_start),
+                            chunk_end - chunk_start))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ProcletManager::write_spill_file(ProcletHeader *proclet_header,
+                                      VAddrRange range) {
+  auto path = get_spill_path(proclet_header);
+  int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
+  if (unlikely(fd < 0)) {
+    return false;
+  }
+  bool written = write_chunks(fd, get_live_chunks(proclet_header, {range}));
+  written = (close(fd) == 0) && written;
+  if (unlikely(!written)) {
+    unlink(path.c_str());
+  }
+  return written;
+}
+
+void ProcletManager::reload(void *proclet_base) {
+  RuntimeSlabGuard guard;
+  auto *proclet_header = reinterpret_cast<ProcletHeader *>(proclet_base);
+  rt::MutexGuard g(&spill_mutex_);
+
+  // Someone else got here first.
+  if (!spilled_proclets_.erase(proclet_base)) {
+    return;
+  }
+  read_spill_file(proclet_header);
+  restore_spilled(proclet_base);
+}
+
+void ProcletManager::read_spill_file(ProcletHeader *proclet_header) {
+  auto path = get_spill_path(proclet_header);
+  int fd = open(path.c_str(), O_RDONLY);
+  BUG_ON(fd < 0);
+
+  BUG_ON(!read_chunks(fd));
+  BUG_ON(close(fd) != 0);
+  BUG_ON(unlink(path.c_str()) != 0);
+}
+
+void ProcletManager::set_checkpoint_dir(std::string dir) {
+  checkpoint_dir_ = std::move(dir);
+}
+
+std::string ProcletManager::get_checkpoint_path(ProcletID id) const {
+  return checkpoint_dir_ + "/nu_" + std::to_string(id) + ".ckpt";
+}
+
+uint32_t ProcletManager::checkpoint(std::span<const ProcletID> ids) {
+  if (checkpoint_dir_.empty()) {
+    return 0;
+  }
+
+  RuntimeSlabGuard guard;
+  for (auto id : ids) {
+    auto *proclet_header = to_proclet_header(id);
+    if (proclet_header->status() == kSpilled) {
+      reload(proclet_header);
+    }
+  }
+
+  rt::MutexGuard g(&spill_mutex_);
+  // All of them are paused before any gets written, so that the checkpoint
+  // is a consistent cut.
+  std::vector<ProcletHeader *> paused;
+  for (auto id : ids) {
+    auto *proclet_header = to_proclet_header(id);
+    if (pause_if_idle(proclet_header)) {
+      paused.push_back(proclet_header);
+    }
+  }
+
+  decltype(checkpoint_states_) states;
+  for (auto *proclet_header : paused) {
+    auto iter = checkpoint_states_.find(proclet_header);
+    bool incremental = checkpoint_tracking_ &&
+                       iter != checkpoint_states_.end() &&
+                       iter->second.generation == proclet_header->generation;
+    CheckpointState state{};
+    if (incremental) {
+      state = iter->second;
+    }
+    if (write_checkpoint_file(proclet_header, incremental, &state)) {
+      states[proclet_header] = state;
+    }
+  }
+
+  // The next deltas are taken against this checkpoint, so the proclets left
+  // out of it have to start over with a full one. Without any, the soft-dirty
+  // bits are left to pre-copy.
+  checkpoint_tracker_.stop();
+  checkpoint_tracking_ = !states.empty() && checkpoint_tracker_.start();
+  checkpoint_states_ = std::move(states);
+
+  for (auto *proclet_header : paused) {
+    restore_spilled(proclet_header);
+  }
+  return checkpoint_states_.size();
+}
+
+// A full record is written to a new file that then replaces the old one, and
+// a delta record with the pages dirtied since the last checkpoint is appended
+// to it. Deltas get compacted into a full record before they cost restores
+// more than it would.
+bool ProcletManager::write_checkpoint_file(ProcletHeader *proclet_header,
+                                           bool incremental,
+                                           CheckpointState *state) {
+  auto start_addr = reinterpret_cast<uint64_t>(proclet_header->copy_start);
+  auto end_addr = reinterpret_cast<uint64_t>(proclet_header->slab.get_base()) +
+                  proclet_header->slab.get_usage();
+  std::vector<VAddrRange> chunks;
+  if (incremental) {
+    std::vector<VAddrRange> ranges;
+    checkpoint_tracker_.get_dirty_ranges(start_addr, end_addr, &ranges);
+    if (!ranges.empty()) {
+      ranges.front().start = std::max(ranges.front().start, start_addr);
+      ranges.back().end = std::min(ranges.back().end, end_addr);
+    }
+    chunks = get_live_chunks(proclet_header, ranges);
+    uint64_t len = 0;
+    for (auto [chunk_start, chunk_end] : chunks) {
+      len += chunk_end - chunk_start;
+    }
+    incremental = state->num_deltas < kMaxNumCheckpointDeltas &&
+                  state->delta_bytes + len <= end_addr - start_addr;
+    if (incremental) {
+      state->num_deltas++;
+      state->delta_bytes += len;
+    }
+  }
+  if (!incremental) {
+    chunks = get_live_chunks(
+        proclet_header, {VAddrRange{.start = start_addr, .end = end_addr}});
+    *state = CheckpointState{.generation = proclet_header->generation,
+                             .num_deltas = 0,
+                             .delta_bytes = 0};
+  }
+
+  // The logical time is kept in the form the migrator transmits it.
+  CheckpointRecord record{
+      .capacity = proclet_header->capacity,
+      .sum_tsc = static_cast<int64_t>(rdtscp(nullptr) - start_tsc) +
+                 proclet_header->time.offset_tsc_};
+
+  auto path = get_checkpoint_path(to_proclet_id(proclet_header));
+  auto tmp_path = incremental ? path : path + ".tmp";
+  int fd = incremental ? open(path.c_str(), O_WRONLY | O_APPEND)
+                       : open(tmp_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY,
+                              0600);
+  if (unlikely(fd < 0)) {
+    return false;
+  }
+  bool written =
+      write_full(fd, &record, sizeof(record)) && write_chunks(fd, chunks);
+  written = (close(fd) == 0) && written;
+  if (!incremental) {
+    written = written && rename(tmp_path.c_str(), path.c_str()) == 0;
+    if (unlikely(!written)) {
+      unlink(tmp_path.c_str());
+    }
+  }
+  return written;
+}
+
+std::vector<ProcletID> ProcletManager::restore_checkpoints() {
+  RuntimeSlabGuard guard;
+  std::vector<ProcletID> ids;
+  if (checkpoint_dir_.empty()) {
+    restored_ids_.clear();
+    return ids;
+  }
+
+  std::error_code ec;
+  for (auto &entry :
+       std::filesystem::directory_iterator(checkpoint_dir_, ec)) {
+    auto name = entry.path().filename().string();
+    if (!name.starts_with("nu_") || !name.ends_with(".ckpt")) {
+      continue;
+    }
+    // The controller rejects ids that do not name a free segment.
+    auto id = std::strtoull(name.c_str() + 3, nullptr, 10);
+    if (restore_checkpoint(id)) {
+      ids.push_back(id);
+    }
+  }
+  restored_ids_ = ids;
+  return ids;
+}
+
+bool ProcletManager::restore_checkpoint(ProcletID id) {
+  auto *proclet_header = to_proclet_header(id);
+  auto path = get_checkpoint_path(id);
+  int fd = open(path.c_str(), O_RDONLY);
+  if (unlikely(fd < 0)) {
+    return false;
+  }
+
+  CheckpointRecord record;
+  std::optional<uint32_t> generation;
+  if (unlikely(!read_full(fd, &record, sizeof(record)) ||
+               record.capacity < kMinProcletHeapSize ||
+               record.capacity > kMaxProcletHeapSize ||
+               !(generation = get_runtime()->controller_client()->claim_proclet(
+                     id, record.capacity)))) {
+    close(fd);
+    return false;
+  }
+
+  auto capacity = record.capacity;
+  auto sum_tsc = record.sum_tsc;
+  bool restored = read_chunks(fd);
+  if (likely(restored)) {
+    // Applies the deltas in order, dropping a torn one at the end.
+    while (read_full(fd, &record, sizeof(record)) && read_chunks(fd)) {
+      sum_tsc = record.sum_tsc;
+    }
+
+    setup(proclet_header, capacity, /* migratable = */ false,
+          /* from_migration = */ true);
+    // The controller starts the claimed segment over.
+    proclet_header->location_generation = *generation;
+    proclet_header->location_epoch = 1;
+    auto *slab = &proclet_header->slab;
+    SlabAllocator::register_slab_by_id(slab, slab->get_id());
+    proclet_header->time.offset_tsc_ =
+        sum_tsc - static_cast<int64_t>(rdtscp(nullptr) - start_tsc);
+    insert(proclet_header);
+    proclet_header->migratable = true;
+  } else {
+    depopulate(proclet_header, capacity, /* defer = */ false);
+    get_runtime()->controller_client()->destroy_proclet(
+        VAddrRange{.start = id, .end = id + capacity});
+  }
+  close(fd);
+  return restored;
+}
+
 }  // namespace nu
@@ -16,7 +16,10 @@ NodeID RPCClientMgr::get_node_id_by_node_ip(NodeIP ip) {
   return id;
 }
 
-RPCClientMgr::RPCClientMgr(uint16_t port) : port_(port), next_node_id_(0) {}
+RPCClientMgr::RPCClientMgr(uint16_t port)
+    : port_(port), next_node_id_(0), num_resolves_(0) {}
+
+uint64_t RPCClientMgr::get_num_resolves() const { return num_resolves_; }
 
 RPCClient *RPCClientMgr::get_client(NodeInfo info) {
   auto &client = rpc_clients_[info.id];
@@ -59,6 +62,7 @@ retry:
     rt::MutexGuard g(&node_info_mutexes_[slab_id]);
     auto &info_ref = rem_id_to_node_info_[slab_id];
     if (!info_ref.raw) {
+      num_resolves_++;
       auto ip = get_runtime()->controller_client()->resolve_proclet(proclet_id);
       BUG_ON(!ip);
       NodeInfo info;
@@ -84,25 +88,69 @@ NodeIP RPCClientMgr::get_ip_by_proclet_id(ProcletID proclet_id) {
 }
 
 void RPCClientMgr::invalidate_cache(ProcletID proclet_id,
-                                    RPCClient *old_client) {
+                                    RPCClient *old_client,
+                                    const RPCReturnBuffer &wrong_client_resp) {
   auto slab_id = to_slab_id(proclet_id);
+  rt::MutexGuard g(&node_info_mutexes_[slab_id]);
+
   auto &info_ref = rem_id_to_node_info_[slab_id];
-  if (info_ref.raw) {
-    if (info_ref.ip != old_client->GetAddr().ip) {
+  bool stale = !info_ref.raw || info_ref.ip == old_client->GetAddr().ip;
+  ProcletLocation cached;
+  cached.ip = info_ref.ip;
+  cached.epoch = info_ref.epoch;
+
+  // The old server may have told us where the proclet went. Follow it as long
+  // as it makes progress; otherwise resolve through the controller. It may
+  // also tell us to come back, once it has loaded the proclet.
+  auto resp = wrong_client_resp.get_buf();
+  if (resp.size() == sizeof(ProcletLocation)) {
+    auto &location = from_span<ProcletLocation>(resp);
+    bool loaded = location.ip == old_client->GetAddr().ip && location.epoch &&
+                  !cached.is_newer_than(location);
+    if ((location.is_newer_than(cached) && (stale || cached.epoch)) ||
+        loaded) {
+      NodeInfo info;
+      info.ip = location.ip;
+      info.id = get_node_id_by_node_ip(location.ip);
+      info.epoch = location.epoch;
+      info_ref = info;
       return;
-    } else {
-      info_ref.raw = 0;
     }
   }
+
+  if (stale) {
+    info_ref.raw = 0;
+  }
 }
 
 void RPCClientMgr::update_cache(ProcletID proclet_id, NodeIP ip) {
   auto slab_id = to_slab_id(proclet_id);
   rt::MutexGuard g(&node_info_mutexes_[slab_id]);
 
-  auto &info = rem_id_to_node_info_[slab_id];
+  NodeInfo info;
   info.ip = ip;
   info.id = get_node_id_by_node_ip(ip);
+  rem_id_to_node_info_[slab_id] = info;
+}
+
+void RPCClientMgr::update_cache(ProcletID proclet_id,
+                                ProcletLocation location) {
+  auto slab_id = to_slab_id(proclet_id);
+  rt::MutexGuard g(&node_info_mutexes_[slab_id]);
+
+  auto &info_ref = rem_id_to_node_info_[slab_id];
+  ProcletLocation cached;
+  cached.ip = info_ref.ip;
+  cached.epoch = info_ref.epoch;
+  if (info_ref.raw && !location.is_newer_than(cached)) {
+    return;
+  }
+
+  NodeInfo info;
+  info.ip = location.ip;
+  info.id = get_node_id_by_node_ip(location.ip);
+  info.epoch = location.epoch;
+  info_ref = info;
 }
 
 }  // namespace nu
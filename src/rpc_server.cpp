@@ -4,6 +4,7 @@
 #include "nu/ctrl_server.hpp"
 #include "nu/migrator.hpp"
 #include "nu/proclet_server.hpp"
+#include "nu/rpc_client_mgr.hpp"
 #include "nu/runtime.hpp"
 #include "nu/utils/rpc.hpp"
 
@@ -35,7 +36,12 @@ void RPCServer::handler_fn(std::span<std::byte> args, RPCReturner *returner) {
       auto &req = from_span<RPCReqMigrateThreadAndRetVal>(args);
       auto rc = req.handler(req.dest_proclet_header, req.dest_ret_val_ptr,
                             req.payload_len, req.payload);
-      returner->Return(rc);
+      if (unlikely(rc == kErrWrongClient)) {
+        get_runtime()->send_rpc_resp_wrong_client(
+            to_proclet_id(req.dest_proclet_header), returner);
+      } else {
+        returner->Return(rc);
+      }
       break;
     }
     // Controller
@@ -54,6 +60,21 @@ void RPCServer::handler_fn(std::span<std::byte> args, RPCReturner *returner) {
       returner->Return(kOk, span, [resp = std::move(resp)] {});
       break;
     }
+    case kAllocateProclets: {
+      auto &req = from_span<RPCReqAllocateProclets>(args);
+      auto resp = std::make_unique<std::vector<ProcletAllocation>>(
+          get_runtime()->controller_server()->handle_allocate_proclets(req));
+      auto span = std::as_bytes(std::span(*resp));
+      returner->Return(kOk, span, [resp = std::move(resp)] {});
+      break;
+    }
+    case kClaimProclet: {
+      auto &req = from_span<RPCReqClaimProclet>(args);
+      auto resp = get_runtime()->controller_server()->handle_claim_proclet(req);
+      auto span = to_span(*resp);
+      returner->Return(kOk, span, [resp = std::move(resp)] {});
+      break;
+    }
     case kDestroyProclet: {
       auto &req = from_span<RPCReqDestroyProclet>(args);
       get_runtime()->controller_server()->handle_destroy_proclet(req);
@@ -86,6 +107,14 @@ void RPCServer::handler_fn(std::span<std::byte> args, RPCReturner *returner) {
       returner->Return(kOk);
       break;
     }
+    case kUpdateCache: {
+      auto &req = from_span<RPCReqUpdateCache>(args);
+      ProcletLocation location;
+      location.raw = req.location_raw;
+      get_runtime()->rpc_client_mgr()->update_cache(req.id, location);
+      returner->Return(kOk);
+      break;
+    }
     case kShutdown: {
       get_runtime()->shutdown(returner);
       break;
@@ -41,17 +41,18 @@ namespace nu {
 
 Runtime::Runtime() {}
 
-Runtime::Runtime(uint32_t remote_ctrl_ip, Mode mode, lpid_t lpid,
-                 bool isol) {
+Runtime::Runtime(uint32_t remote_ctrl_ip, Mode mode, lpid_t lpid, bool isol,
+                 const ServerOptions &options) {
   init_base();
 
   if (mode == kMainServer) {
-    init_as_server(remote_ctrl_ip, lpid, /* main = */ true, isol);
+    init_as_server(remote_ctrl_ip, lpid, /* main = */ true, isol, options);
   } else {
     if (mode == kController) {
       init_as_controller();
     } else if (mode == kServer) {
-      init_as_server(remote_ctrl_ip, lpid, /* main = */ false, isol);
+      init_as_server(remote_ctrl_ip, lpid, /* main = */ false, isol,
+                     options);
     } else {
       BUG();
     }
@@ -86,7 +87,7 @@ void Runtime::init_as_controller() {
 }
 
 void Runtime::init_as_server(uint32_t remote_ctrl_ip, lpid_t lpid, bool main,
-                             bool isol) {
+                             bool isol, const ServerOptions &options) {
   proclet_server_ = new ProcletServer();
   migrator_ = new Migrator();
   controller_client_ = new ControllerClient(remote_ctrl_ip, lpid, main, isol);
@@ -95,6 +96,14 @@ void Runtime::init_as_server(uint32_t remote_ctrl_ip, lpid_t lpid, bool main,
   archive_pool_ = new ArchivePool<>();
   pressure_handler_ = new PressureHandler();
   resource_reporter_ = new ResourceReporter();
+
+  migrator_->set_bandwidth_budget(options.migration_bw_gbs);
+  migrator_->set_trace_path(options.migration_trace_path);
+  proclet_manager_->set_spill_dir(options.spill_dir);
+  proclet_manager_->set_checkpoint_dir(options.checkpoint_dir);
+  if (options.restore) {
+    proclet_manager_->restore_checkpoints();
+  }
 }
 
 void Runtime::init_base() {
@@ -121,6 +130,10 @@ void Runtime::send_rpc_resp_ok(ArchivePool<>::OASStream *oa_sstream,
   if (likely(!caladan_->thread_has_been_migrated())) {
     auto span = std::span(data, len);
 
+    if (returner->recv_tsc) {
+      migrator_->report_foreground_latency(rdtsc() - returner->recv_tsc);
+    }
+
     returner->Return(kOk, span, [this, oa_sstream]() {
       archive_pool_->put_oa_sstream(oa_sstream);
     });
@@ -130,9 +143,33 @@ void Runtime::send_rpc_resp_ok(ArchivePool<>::OASStream *oa_sstream,
   }
 }
 
-void Runtime::send_rpc_resp_wrong_client(RPCReturner *returner) {
+void Runtime::send_rpc_resp_wrong_client(ProcletID id,
+                                         RPCReturner *returner) {
   BUG_ON(caladan_->thread_has_been_migrated());
-  returner->Return(kErrWrongClient);
+
+  auto *proclet_header = to_proclet_header(id);
+  if constexpr (Migrator::kHoldRequestsDuringMigration) {
+    migrator_->wait_until_loaded(proclet_header);
+    ProcletManager::wait_until_handed_off(proclet_header);
+  }
+
+  // Piggyback where the proclet went, if known, to spare the caller from
+  // resolving it through the controller. A proclet that got loaded while the
+  // request was held is here.
+  ProcletLocation location;
+  if (load_acquire(&proclet_header->status()) == kPresent) {
+    location.ip = get_cfg_ip();
+    location.epoch = proclet_header->location_epoch;
+  } else {
+    location = proclet_header->forward_location();
+  }
+  if (location.raw) {
+    auto resp = std::make_unique<ProcletLocation>(location);
+    auto span = to_span(*resp);
+    returner->Return(kErrWrongClient, span, [resp = std::move(resp)] {});
+  } else {
+    returner->Return(kErrWrongClient);
+  }
 }
 
 void Runtime::shutdown(RPCReturner *returner) {
@@ -198,6 +235,13 @@ int runtime_main_init(int argc, char **argv,
   auto lpid = all_options_desc.nu.lpid;
   auto conf_path = all_options_desc.caladan.conf_path;
   auto isol = all_options_desc.vm.count("isol");
+  ServerOptions server_options;
+  server_options.migration_bw_gbs = all_options_desc.nu.migration_bw_gbs;
+  server_options.migration_trace_path =
+      all_options_desc.nu.migration_trace_path;
+  server_options.spill_dir = all_options_desc.nu.spill_dir;
+  server_options.checkpoint_dir = all_options_desc.nu.checkpoint_dir;
+  server_options.restore = all_options_desc.vm.count("restore");
   if (conf_path.empty()) {
     conf_path = ".conf_" + std::to_string(getpid());
     write_options_to_file(conf_path, all_options_desc);
@@ -240,7 +284,7 @@ int runtime_main_init(int argc, char **argv,
       }
     }
     auto *runtime = get_runtime_nocheck();
-    new (runtime) Runtime(ctrl_ip, mode, lpid, isol);
+    new (runtime) Runtime(ctrl_ip, mode, lpid, isol, server_options);
     setup_main_proclet(runtime);
     main_func(argc, argv);
     get_runtime()->controller_client()->destroy_lp();
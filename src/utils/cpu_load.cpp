@@ -66,4 +66,12 @@ float CPULoad::get_avg_load() const {
   return avg_cpu_load;
 }
 
+uint64_t CPULoad::get_num_invocations() const {
+  uint64_t sum_invocation_cnts = 0;
+  for (uint32_t i = 0; i < kNumCores; i++) {
+    sum_invocation_cnts += cnts_[i].invocations;
+  }
+  return sum_invocation_cnts;
+}
+
 }  // namespace nu
@@ -0,0 +1,83 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+extern "C" {
+#include <base/assert.h>
+}
+
+#include "nu/utils/dirty_page_tracker.hpp"
+
+namespace nu {
+
+rt::Mutex DirtyPageTracker::mutex_;
+
+DirtyPageTracker::DirtyPageTracker() : pagemap_fd_(-1), started_(false) {}
+
+DirtyPageTracker::~DirtyPageTracker() { stop(); }
+
+bool DirtyPageTracker::start() {
+  BUG_ON(started_);
+  // Never waits, as the pressure handler must not park.
+  if (!mutex_.TryLock()) {
+    return false;
+  }
+
+  pagemap_fd_ = open("/proc/self/pagemap", O_RDONLY);
+  auto clear_refs_fd = open("/proc/self/clear_refs", O_WRONLY);
+  // "4" clears the soft-dirty bits of all pages.
+  bool cleared = clear_refs_fd >= 0 && write(clear_refs_fd, "4", 1) == 1;
+  if (clear_refs_fd >= 0) {
+    close(clear_refs_fd);
+  }
+  if (unlikely(pagemap_fd_ < 0 || !cleared)) {
+    if (pagemap_fd_ >= 0) {
+      close(pagemap_fd_);
+      pagemap_fd_ = -1;
+    }
+    mutex_.Unlock();
+    return false;
+  }
+
+  started_ = true;
+  return true;
+}
+
+void DirtyPageTracker::get_dirty_ranges(uint64_t start, uint64_t end,
+                                        std::vector<VAddrRange> *ranges) {
+  BUG_ON(!started_);
+  uint64_t entries[kNumEntriesPerRead];
+
+  auto start_pfn = start / kPageSize;
+  auto end_pfn = (end + kPageSize - 1) / kPageSize;
+  for (auto pfn = start_pfn; pfn < end_pfn; pfn += kNumEntriesPerRead) {
+    auto num_entries = std::min<uint64_t>(kNumEntriesPerRead, end_pfn - pfn);
+    auto len = num_entries * sizeof(uint64_t);
+    BUG_ON(pread(pagemap_fd_, entries, len, pfn * sizeof(uint64_t)) !=
+           static_cast<ssize_t>(len));
+
+    for (uint64_t i = 0; i < num_entries; i++) {
+      if (!(entries[i] & kSoftDirtyBit)) {
+        continue;
+      }
+      auto addr = (pfn + i) * kPageSize;
+      if (!ranges->empty() && ranges->back().end == addr) {
+        ranges->back().end += kPageSize;
+      } else {
+        ranges->push_back(VAddrRange{.start = addr, .end = addr + kPageSize});
+      }
+    }
+  }
+}
+
+void DirtyPageTracker::stop() {
+  if (started_) {
+    close(pagemap_fd_);
+    pagemap_fd_ = -1;
+    started_ = false;
+    mutex_.Unlock();
+  }
+}
+
+}  // namespace nu
@@ -0,0 +1,66 @@
+#include <algorithm>
+
+#include "nu/utils/migration_cost_model.hpp"
+#include "nu/utils/scoped_lock.hpp"
+
+namespace nu {
+
+MigrationCostModel::MigrationCostModel()
+    : default_params_{.fixed_cost_us = kDefaultFixedCostUs,
+                      .bytes_per_us = kDefaultNetBwGbps * 1000 / 8} {}
+
+void MigrationCostModel::Fit::add(double x, double y) {
+  n = n * kDecay + 1;
+  sum_x = sum_x * kDecay + x;
+  sum_y = sum_y * kDecay + y;
+  sum_xx = sum_xx * kDecay + x * x;
+  sum_xy = sum_xy * kDecay + x * y;
+}
+
+std::optional<MigrationCostModel::Params> MigrationCostModel::Fit::solve()
+    const {
+  if (n < kMinNumSamples) {
+    return std::nullopt;
+  }
+
+  double slope, intercept;
+  auto det = n * sum_xx - sum_x * sum_x;
+  if (det > 1e-6 * n * sum_xx) {
+    slope = (n * sum_xy - sum_x * sum_y) / det;
+    intercept = (sum_y - slope * sum_x) / n;
+  } else {
+    // The sizes are too alike to tell the overhead apart from the transfer.
+    intercept = kDefaultFixedCostUs;
+    slope = sum_x ? (sum_y - n * intercept) / sum_x : 0;
+  }
+  if (slope <= 0) {
+    return std::nullopt;
+  }
+  return Params{.fixed_cost_us = static_cast<float>(std::max(intercept, 0.0)),
+                .bytes_per_us = static_cast<float>(1 / slope)};
+}
+
+void MigrationCostModel::add_sample(NodeIP dest_ip, uint64_t bytes,
+                                    uint64_t duration_us) {
+  ScopedLock lock(&spin_);
+  all_fit_.add(bytes, duration_us);
+  dest_fits_[dest_ip].add(bytes, duration_us);
+}
+
+MigrationCostModel::Params MigrationCostModel::get_params() {
+  ScopedLock lock(&spin_);
+  return all_fit_.solve().value_or(default_params_);
+}
+
+MigrationCostModel::Params MigrationCostModel::get_params(NodeIP dest_ip) {
+  ScopedLock lock(&spin_);
+  auto iter = dest_fits_.find(dest_ip);
+  if (iter != dest_fits_.end()) {
+    if (auto params = iter->second.solve()) {
+      return *params;
+    }
+  }
+  return all_fit_.solve().value_or(default_params_);
+}
+
+}  // namespace nu
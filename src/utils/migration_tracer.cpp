@@ -0,0 +1,169 @@
+#include <iomanip>
+#include <iterator>
+#include <string>
+#include <utility>
+
+extern "C" {
+#include <base/time.h>
+#include <net/ip.h>
+}
+
+#include "nu/utils/migration_tracer.hpp"
+
+namespace nu {
+
+namespace {
+
+constexpr const char *kPhaseNames[] = {
+    "pick_tasks",
+    "acquire_node",
+    "approval_wait",
+    "pre_copy",
+    "pause",
+    "transmit_heap",
+    "transmit_mutexes",
+    "transmit_condvars",
+    "transmit_threads",
+    "transmit_time",
+    "update_location",
+    "cleanup",
+    "populate",
+    "load_heap",
+    "load_mutexes",
+    "load_condvars",
+    "load_threads",
+    "load_time"};
+static_assert(std::size(kPhaseNames) == MigrationSpan::kNumPhases);
+
+double tsc_to_us(uint64_t tsc) {
+  return static_cast<double>(tsc) / cycles_per_us;
+}
+
+std::string ip_to_str(NodeIP ip) {
+  char buf[IP_ADDR_STR_LEN];
+  return ip_addr_to_str(ip, buf);
+}
+
+}  // namespace
+
+MigrationTracer::MigrationTracer()
+    : enabled_(false),
+      next_seq_(0),
+      num_finished_records_(0),
+      records_(kMaxNumRecords) {}
+
+const char *MigrationTracer::phase_name(MigrationSpan::Phase phase) {
+  return kPhaseNames[phase];
+}
+
+std::unique_ptr<MigrationRecord> MigrationTracer::start_record(bool is_source,
+                                                               NodeIP peer_ip) {
+  if (!enabled_) {
+    return nullptr;
+  }
+
+  auto record = std::make_unique<MigrationRecord>();
+  record->is_source = is_source;
+  record->peer_ip = peer_ip;
+  record->num_proclets = 0;
+  record->start_us = microtime();
+  record->start_tsc = rdtsc();
+
+  rt::SpinGuard lock(&spin_);
+  record->seq = next_seq_++;
+  if (is_source) {
+    record->spans.swap(prologue_);
+    for (auto &span : record->spans) {
+      if (span.start_tsc < record->start_tsc) {
+        record->start_us -= tsc_to_us(record->start_tsc - span.start_tsc);
+        record->start_tsc = span.start_tsc;
+      }
+    }
+  }
+  return record;
+}
+
+void MigrationTracer::finish_record(std::unique_ptr<MigrationRecord> record) {
+  if (!record) {
+    return;
+  }
+  record->end_tsc = rdtsc();
+
+  rt::SpinGuard lock(&spin_);
+  records_.push_back(std::move(record));
+  num_finished_records_++;
+}
+
+void MigrationTracer::add_prologue(MigrationSpan::Phase phase,
+                                   uint64_t start_tsc, uint64_t end_tsc) {
+  if (!enabled_) {
+    return;
+  }
+
+  rt::SpinGuard lock(&spin_);
+  // Bounded, in case no migration follows.
+  if (prologue_.size() == kMaxNumPrologueSpans) {
+    prologue_.erase(prologue_.begin());
+  }
+  prologue_.push_back(MigrationSpan{.phase = phase,
+                                    .lane = 0,
+                                    .proclet_id = 0,
+                                    .start_tsc = start_tsc,
+                                    .end_tsc = end_tsc});
+}
+
+void MigrationTracer::write_records(std::ostream &os) {
+  rt::SpinGuard lock(&spin_);
+
+  os << "seq role peer_ip num_proclets total_us";
+  for (uint32_t i = 0; i < MigrationSpan::kNumPhases; i++) {
+    os << " " << kPhaseNames[i] << "_us";
+  }
+  os << std::endl;
+
+  for (auto &record : records_) {
+    double phase_us[MigrationSpan::kNumPhases] = {};
+    for (auto &span : record->spans) {
+      phase_us[span.phase] += tsc_to_us(span.end_tsc - span.start_tsc);
+    }
+    os << record->seq << " " << (record->is_source ? "src" : "dst") << " "
+       << ip_to_str(record->peer_ip) << " " << record->num_proclets << " "
+       << tsc_to_us(record->end_tsc - record->start_tsc);
+    for (auto us : phase_us) {
+      os << " " << us;
+    }
+    os << std::endl;
+  }
+}
+
+void MigrationTracer::write_chrome_trace(std::ostream &os) {
+  rt::SpinGuard lock(&spin_);
+
+  // Every migration is shown as a process, and its lanes as threads.
+  os << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+  bool first = true;
+  auto separator = [&] { return std::exchange(first, false) ? "\n" : ",\n"; };
+  for (auto &record : records_) {
+    os << separator() << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":"
+       << record->seq << ",\"args\":{\"name\":\"migration " << record->seq
+       << (record->is_source ? " to " : " from ")
+       << ip_to_str(record->peer_ip) << "\"}}";
+    for (auto &span : record->spans) {
+      auto ts_us =
+          record->start_us + tsc_to_us(span.start_tsc - record->start_tsc);
+      os << separator() << "{\"name\":\"" << kPhaseNames[span.phase]
+         << "\",\"cat\":\"" << (record->is_source ? "src" : "dst")
+         << "\",\"ph\":\"X\",\"ts\":" << ts_us
+         << ",\"dur\":" << tsc_to_us(span.end_tsc - span.start_tsc)
+         << ",\"pid\":" << record->seq << ",\"tid\":" << span.lane;
+      if (span.proclet_id) {
+        os << ",\"args\":{\"proclet\":\"0x" << std::hex << span.proclet_id
+           << std::dec << "\"}";
+      }
+      os << "}";
+    }
+  }
+  os << "\n]}" << std::endl;
+}
+
+}  // namespace nu
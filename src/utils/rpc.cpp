@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <type_traits>
 
 extern "C" {
@@ -14,44 +15,70 @@ namespace nu {
 namespace {
 
 // Command types for the RPC protocol.
-enum rpc_cmd : unsigned int {
+enum rpc_cmd : uint16_t {
   call = 0,
   update,
 };
 
 // Binary header format for requests sent by client.
 struct rpc_req_hdr {
-  rpc_cmd cmd;          // the command type
-  unsigned int demand;  // number of RPCs waiting to be sent and inflight
-  std::size_t len;      // the length of this RPC request
+  rpc_cmd cmd;                  // the command type
+  RPCPriority priority;         // the priority of this RPC request
+  unsigned int demand;          // number of RPCs queued and inflight
+  std::size_t len;              // the length of this RPC request
   std::size_t completion_data;  // an opaque token to complete the RPC
 };
 
-constexpr rpc_req_hdr MakeCallRequest(unsigned int demand, std::size_t len,
+constexpr rpc_req_hdr MakeCallRequest(RPCPriority priority,
+                                      unsigned int demand, std::size_t len,
                                       std::size_t completion_data) {
-  return rpc_req_hdr{rpc_cmd::call, demand, len, completion_data};
+  return rpc_req_hdr{rpc_cmd::call, priority, demand, len, completion_data};
 }
 
 constexpr rpc_req_hdr MakeUpdateRequest(unsigned int demand) {
-  return rpc_req_hdr{rpc_cmd::update, demand, 0, 0};
+  return rpc_req_hdr{rpc_cmd::update, kNormalPriority, demand, 0, 0};
+}
+
+// Spawns a request handler. High-priority handlers go to the head of the run
+// queue, while low-priority ones yield once to let queued work run first.
+template <typename F>
+void SpawnHandler(RPCPriority priority, F &&f) {
+  if (priority == kHighPriority) {
+    void *buf;
+    thread_t *th = thread_create_with_buf(
+        rt::thread_internal::ThreadTrampoline, &buf,
+        sizeof(std::move_only_function<void()>));
+    BUG_ON(!th);
+    new (buf) std::move_only_function<void()>(std::forward<F>(f));
+    thread_ready_head(th);
+  } else if (priority == kLowPriority) {
+    rt::Spawn([f = std::forward<F>(f)]() mutable {
+      rt::Yield();
+      f();
+    });
+  } else {
+    rt::Spawn(std::forward<F>(f));
+  }
 }
 
 // Binary header format for responses sent by server.
 struct rpc_resp_hdr {
   rpc_cmd cmd;                  // the command type
+  int16_t rc;                   // the return code
   unsigned int credits;         // the number of credits available
-  ssize_t len;                  // the length of this RPC response,
-                                // < 0 indicates an error
+  std::size_t len;              // the length of the response data
   std::size_t completion_data;  // an opaque token to complete the RPC
 };
 
-constexpr rpc_resp_hdr MakeCallResponse(unsigned int credits, ssize_t len,
+constexpr rpc_resp_hdr MakeCallResponse(unsigned int credits,
+                                        RPCReturnCode rc, std::size_t len,
                                         std::size_t completion_data) {
-  return rpc_resp_hdr{rpc_cmd::call, credits, len, completion_data};
+  return rpc_resp_hdr{rpc_cmd::call, static_cast<int16_t>(rc), credits, len,
+                      completion_data};
 }
 
 constexpr rpc_resp_hdr MakeUpdateResponse(unsigned int credits) {
-  return rpc_resp_hdr{rpc_cmd::update, credits, 0, 0};
+  return rpc_resp_hdr{rpc_cmd::update, kOk, credits, 0, 0};
 }
 
 }  // namespace
@@ -64,20 +91,19 @@ void RPCCompletion::Poll() const {
   }
 }
 
-void RPCCompletion::Done(ssize_t len, rt::TcpConn *c) {
-  if (unlikely(len < 0)) {
-    rc_ = static_cast<RPCReturnCode>(len);
-  } else {
-    rc_ = kOk;
-
-    if (callback_) {
-      callback_(len, c);
-    } else if (len) {
-      auto buf = std::make_unique_for_overwrite<std::byte[]>(len);
-      auto ret = c->ReadFull(buf.get(), len);
-      if (unlikely(ret <= 0)) {
-        log_err("rpc: ReadFull failed, err = %ld", ret);
-      }
+void RPCCompletion::Done(RPCReturnCode rc, std::size_t len, rt::TcpConn *c) {
+  rc_ = rc;
+
+  if (callback_ && likely(rc == kOk)) {
+    callback_(len, c);
+  } else if (len) {
+    auto buf = std::make_unique_for_overwrite<std::byte[]>(len);
+    auto ret = c->ReadFull(buf.get(), len);
+    if (unlikely(ret <= 0)) {
+      log_err("rpc: ReadFull failed, err = %ld", ret);
+    }
+    // Callback-based calls have no use for the data attached to an error.
+    if (!callback_) {
       auto span = std::span<const std::byte>(buf.get(), len);
       return_buf_->Reset(span, [buf = std::move(buf)] {});
     }
@@ -124,6 +150,10 @@ void RPCServerWorker::SendWorker() {
                 std::back_inserter(completions));
       completions_.clear();
     }
+    // Put responses to high-priority requests first on the wire.
+    std::stable_partition(
+        completions.begin(), completions.end(),
+        [](const completion &c) { return c.priority == kHighPriority; });
     // Check if the connection is closed.
     if (unlikely(close_ && completions.empty())) break;
     // process each of the requests.
@@ -132,8 +162,8 @@ void RPCServerWorker::SendWorker() {
     hdrs.reserve(completions.size());
     for (const auto &c : completions) {
       auto span = c.buf.get_buf();
-      hdrs.emplace_back(MakeCallResponse(
-          credits_, c.rc == kOk ? span.size_bytes() : c.rc, c.completion_data));
+      hdrs.emplace_back(MakeCallResponse(credits_, c.rc, span.size_bytes(),
+                                         c.completion_data));
       iovecs.emplace_back(&hdrs.back(), sizeof(decltype(hdrs)::value_type));
       if (span.size_bytes() == 0) continue;
       iovecs.emplace_back(const_cast<std::byte *>(span.data()),
@@ -164,15 +194,17 @@ void RPCServerWorker::ReceiveWorker() {
 
     // Parse the request header.
     std::size_t completion_data = hdr.completion_data;
+    auto priority = hdr.priority;
     demand_ = hdr.demand;
     if (hdr.cmd != rpc_cmd::call) continue;
 
     // Spawn a handler with no argument data provided.
     if (hdr.len == 0) {
       counter_.inc();
+      auto recv_tsc = rdtsc();
       // TODO: avoid dynamic memory allocation.
-      rt::Spawn([this, completion_data]() {
-        auto returner = RPCReturner(this, completion_data);
+      SpawnHandler(priority, [this, completion_data, priority, recv_tsc]() {
+        auto returner = RPCReturner(this, completion_data, priority, recv_tsc);
         handler_(std::span<std::byte>{}, &returner);
         counter_.dec();
       });
@@ -190,13 +222,14 @@ void RPCServerWorker::ReceiveWorker() {
 
     // Spawn a handler with argument data provided.
     counter_.inc();
+    auto recv_tsc = rdtsc();
     // TODO: avoid dynamic memory allocation.
-    rt::Spawn(
-        [this, completion_data, b = std::move(buf), len = hdr.len]() mutable {
-          auto returner = RPCReturner(this, completion_data);
-          handler_(std::span<std::byte>{b.get(), len}, &returner);
-          counter_.dec();
-        });
+    SpawnHandler(priority, [this, completion_data, priority, recv_tsc,
+                            b = std::move(buf), len = hdr.len]() mutable {
+      auto returner = RPCReturner(this, completion_data, priority, recv_tsc);
+      handler_(std::span<std::byte>{b.get(), len}, &returner);
+      counter_.dec();
+    });
   }
 
   // Wake the sender to close the connection.
@@ -218,7 +251,7 @@ RPCFlow::~RPCFlow() {
 }
 
 inline bool RPCFlow::EnoughBatching() {
-  return reqs_.size() >= kReqBatchSize ||
+  return num_queued_reqs_ >= kReqBatchSize ||
          microtime() - last_sent_us_ >= kBatchTimeoutUs;
 }
 
@@ -240,21 +273,25 @@ void RPCFlow::SendWorker() {
       // wait for an actionable state.
       rt::SpinGuard guard(&lock_);
       inflight = sent_count_ - recv_count_;
-      while ((reqs_.empty() || inflight >= credits_) &&
-             !(close_ && reqs_.empty())) {
+      while ((!num_queued_reqs_ || inflight >= credits_) &&
+             !(close_ && !num_queued_reqs_)) {
         guard.Park(&wake_sender_);
         inflight = sent_count_ - recv_count_;
       }
 
-      // gather queued requests up to the credit limit.
+      // gather queued requests up to the credit limit, higher priority first.
       last_sent_us_ = microtime();
-      while (!reqs_.empty() && inflight < credits_) {
-        reqs.emplace_back(reqs_.front());
-        reqs_.pop();
-        inflight++;
+      for (int prio = kNumRPCPriorities - 1; prio >= 0; prio--) {
+        auto &q = reqs_[prio];
+        while (!q.empty() && inflight < credits_) {
+          reqs.emplace_back(q.front());
+          q.pop();
+          inflight++;
+        }
       }
+      num_queued_reqs_ -= reqs.size();
       sent_count_ += reqs.size();
-      close = close_ && reqs_.empty();
+      close = close_ && !num_queued_reqs_;
       demand = inflight;
     }
 
@@ -268,7 +305,7 @@ void RPCFlow::SendWorker() {
     for (const auto &r : reqs) {
       auto &span = r.payload;
       hdrs.emplace_back(
-          MakeCallRequest(demand, span.size_bytes(),
+          MakeCallRequest(r.priority, demand, span.size_bytes(),
                           reinterpret_cast<std::size_t>(r.completion)));
       iovecs.emplace_back(&hdrs.back(), sizeof(decltype(hdrs)::value_type));
       if (span.size_bytes() == 0) continue;
@@ -304,14 +341,14 @@ void RPCFlow::ReceiveWorker() {
       rt::SpinGuard guard(&lock_);
       unsigned int inflight = sent_count_ - ++recv_count_;
       // credits_ = hdr.credits;
-      if (credits_ > inflight && !reqs_.empty()) wake_sender_.Wake();
+      if (credits_ > inflight && num_queued_reqs_) wake_sender_.Wake();
     }
 
     if (hdr.cmd != rpc_cmd::call) continue;
 
     // Check if there is no return data.
     auto *completion = reinterpret_cast<RPCCompletion *>(hdr.completion_data);
-    completion->Done(hdr.len, c_.get());
+    completion->Done(static_cast<RPCReturnCode>(hdr.rc), hdr.len, c_.get());
   }
 }
 
@@ -287,6 +287,45 @@ void SlabAllocator::free_to_transferred_cache_list(PtrHeader *hdr,
   }
 }
 
+std::vector<VAddrRange> SlabAllocator::get_free_regions(uint64_t min_len) {
+  std::vector<VAddrRange> regions;
+
+  for (uint32_t slab_shift = 0; slab_shift < kMaxSlabClassShift;
+       slab_shift++) {
+    auto slab_size = get_slab_size(slab_shift);
+    if (slab_size < min_len) {
+      continue;
+    }
+
+    // The head of a free block may hold a batch of the free list.
+    auto add_block = [&](void *block) {
+      auto addr = reinterpret_cast<uint64_t>(block);
+      auto start = addr + sizeof(FreePtrsLinkedList::Batch);
+      start = (start + kPageSize - 1) / kPageSize * kPageSize;
+      auto end = (addr + slab_size) / kPageSize * kPageSize;
+      if (start < end && end - start >= min_len) {
+        regions.push_back(VAddrRange{.start = start, .end = end});
+      }
+    };
+    {
+      ScopedLock lock(&spin_);
+      slab_lists_[slab_shift].for_each(add_block);
+    }
+    for (auto &cache : cache_lists_) {
+      cache.lists[slab_shift].for_each(add_block);
+    }
+    if constexpr (kEnableTransferCache) {
+      for (auto &cache : transferred_caches_) {
+        ScopedLock lock(&cache.spin);
+        cache.lists[slab_shift].for_each(add_block);
+      }
+    }
+  }
+
+  std::sort(regions.begin(), regions.end());
+  return regions;
+}
+
 void *SlabAllocator::yield(size_t size) {
   ScopedLock lock(&spin_);
   size = (((size - 1) / kAlignment) + 1) * kAlignment;
@@ -8,6 +8,10 @@ SERVER_IP="18.18.1.2"
 MAIN_SERVER_IP="18.18.1.3"
 LPID=1
 SKIPPED_TESTS=("test_continuous_migrate")
+# Run twice, the second time restoring the checkpoints of the first on both
+# servers.
+RESTART_TESTS=("test_checkpoint_restart")
+CHECKPOINT_DIR="/tmp/nu_test_checkpoint_restart"
 
 all_passed=1
 tests_prefix=
@@ -59,6 +63,54 @@ function run_test {
     return $ret
 }
 
+function run_restart_test {
+    BIN="$SHARED_SCRIPT_DIR/bin/$1"
+    SRV_CKPT_ARGS="--checkpoint_dir $CHECKPOINT_DIR/server"
+    MAIN_CKPT_ARGS="--checkpoint_dir $CHECKPOINT_DIR/main"
+
+    sudo rm -rf $CHECKPOINT_DIR
+    sudo mkdir -p $CHECKPOINT_DIR/server $CHECKPOINT_DIR/main
+
+    run_controller 1>.log.$1.ctrl 2>&1 &
+    disown -r
+    sleep 3
+
+    run_server "$BIN $SRV_CKPT_ARGS" 1>.log.$1.srv 2>&1 &
+    disown -r
+    sleep 3
+
+    run_main_server "$BIN $MAIN_CKPT_ARGS" 1>.log.$1.main 2>&1
+    cat .log.$1.main | grep -q "Checkpointed"
+    ret=$?
+
+    kill_process test_
+    kill_controller
+    sleep 5
+
+    if [[ $ret == 0 ]]; then
+        run_controller 1>.log.$1.ctrl.restart 2>&1 &
+        disown -r
+        sleep 3
+
+        run_server "$BIN $SRV_CKPT_ARGS --restore" 1>.log.$1.srv.restart 2>&1 &
+        disown -r
+        sleep 3
+
+        run_main_server "$BIN $MAIN_CKPT_ARGS --restore" 1>.log.$1.main.restart 2>&1
+        cat .log.$1.main.restart | grep -q "Passed"
+        ret=$?
+
+        kill_process test_
+        kill_controller
+        sleep 5
+    fi
+
+    sudo mv core core.$1 1>/dev/null 2>&1
+    sudo rm -rf $CHECKPOINT_DIR
+
+    return $ret
+}
+
 function run_tests {
     TESTS=`ls bin | grep $1`
     for test in $TESTS
@@ -68,7 +120,11 @@ function run_tests {
 	fi
 	echo "Running test $test..."
 	rerun_iokerneld
-	run_test $test
+	if [[ " ${RESTART_TESTS[*]} " =~ " $test " ]]; then
+	    run_restart_test $test
+	else
+	    run_test $test
+	fi
 	if [[ $? == 0 ]]; then
             say_passed
 	else
@@ -0,0 +1,66 @@
+#include <cstdint>
+#include <iostream>
+#include <set>
+#include <vector>
+
+extern "C" {
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/proclet.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+constexpr static uint32_t kNumProclets = 64;
+constexpr static uint64_t kMagic = 0xDEADBEEF;
+
+class Obj {
+ public:
+  Obj(uint64_t magic, std::vector<uint64_t> vec)
+      : magic_(magic), vec_(std::move(vec)) {}
+  uint64_t get_magic() { return magic_; }
+  uint64_t get_sum() {
+    uint64_t sum = 0;
+    for (auto x : vec_) {
+      sum += x;
+    }
+    return sum;
+  }
+  void append(uint64_t x) { vec_.push_back(x); }
+
+ private:
+  uint64_t magic_;
+  std::vector<uint64_t> vec_;
+};
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    bool passed = true;
+
+    std::vector<uint64_t> vec{1, 2, 3};
+    auto future =
+        make_proclets_async<Obj>(kNumProclets, std::make_tuple(kMagic, vec));
+    auto proclets = std::move(future.get());
+    passed &= (proclets.size() == kNumProclets);
+
+    std::set<ProcletID> ids;
+    for (auto &proclet : proclets) {
+      ids.insert(proclet.get_id());
+      passed &= (proclet.run(&Obj::get_magic) == kMagic);
+    }
+    passed &= (ids.size() == kNumProclets);
+
+    // Every proclet owns a separate copy of the args.
+    proclets.front().run(&Obj::append, static_cast<uint64_t>(4));
+    passed &= (proclets.front().run(&Obj::get_sum) == 10);
+    passed &= (proclets.back().run(&Obj::get_sum) == 6);
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}
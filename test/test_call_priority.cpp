@@ -0,0 +1,79 @@
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include <base/time.h>
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/proclet.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+constexpr static uint32_t kNumBackgroundCalls = 1000;
+constexpr static uint32_t kNumForegroundCalls = 100;
+constexpr static uint64_t kBackgroundCallUs = 100;
+
+class Obj {
+ public:
+  // Returns its position in the completion order.
+  uint64_t background() {
+    delay_us(kBackgroundCallUs);
+    return ++seq_;
+  }
+  uint64_t foreground(uint64_t x) { return x; }
+  uint64_t probe() { return ++seq_; }
+
+ private:
+  std::atomic<uint64_t> seq_ = 0;
+};
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    bool passed = true;
+    auto ip = MAKE_IP_ADDR(18, 18, 1, 2);
+    auto proclet = make_proclet<Obj>(false, std::nullopt, ip);
+
+    std::vector<Future<uint64_t>> background_futures;
+    for (uint32_t i = 0; i < kNumBackgroundCalls; i++) {
+      background_futures.emplace_back(
+          proclet.run_async<true, true, true, kLowPriority>(&Obj::background));
+    }
+
+    auto start_us = microtime();
+    for (uint64_t i = 0; i < kNumForegroundCalls; i++) {
+      passed &= (proclet.run<true, true, true, kHighPriority>(
+                     &Obj::foreground, i) == i);
+    }
+    auto foreground_us = microtime() - start_us;
+
+    for (auto &future : background_futures) {
+      future.get();
+    }
+
+    // A high-priority call queued behind a backlog of normal ones
+    // overtakes the calls still waiting in it.
+    for (uint32_t i = 0; i < kNumBackgroundCalls; i++) {
+      background_futures[i] = proclet.run_async(&Obj::background);
+    }
+    auto probe_seq = proclet.run<true, true, true, kHighPriority>(&Obj::probe);
+    uint32_t num_overtaken = 0;
+    for (auto &future : background_futures) {
+      num_overtaken += (future.get() > probe_seq);
+    }
+    passed &= (num_overtaken > 0);
+
+    std::cout << "foreground latency: " << foreground_us / kNumForegroundCalls
+              << " us" << std::endl;
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}
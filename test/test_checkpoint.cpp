@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/commons.hpp"
+#include "nu/proclet.hpp"
+#include "nu/proclet_mgr.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+constexpr static uint32_t kNumElems = 4 << 20;
+// Larger than the warm pool takes, so that the segment goes back to the
+// controller on destruction.
+constexpr static uint64_t kCapacity = 4 * kDefaultProcletHeapSize;
+constexpr static char kCheckpointDir[] = "/tmp/nu_test_checkpoint";
+
+class Obj {
+ public:
+  Obj() : vec_(kNumElems) { std::iota(vec_.begin(), vec_.end(), 0); }
+  void bump() { vec_[kNumElems / 2]++; }
+  bool check(uint32_t num_bumps) {
+    for (uint32_t i = 0; i < kNumElems; i++) {
+      auto expected = i + (i == kNumElems / 2 ? num_bumps : 0);
+      if (vec_[i] != expected) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::vector<uint32_t> vec_;
+};
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    bool passed = true;
+    auto *proclet_manager = get_runtime()->proclet_manager();
+    std::filesystem::remove_all(kCheckpointDir);
+    std::filesystem::create_directories(kCheckpointDir);
+    proclet_manager->set_checkpoint_dir(kCheckpointDir);
+
+    auto proclet = make_proclet<Obj>(false, kCapacity, get_cfg_ip());
+    auto id = proclet.get_id();
+    ProcletID ids[] = {id};
+    passed &= (proclet_manager->checkpoint(ids) == 1);
+
+    auto path = std::string(kCheckpointDir) + "/nu_" + std::to_string(id) +
+                ".ckpt";
+    auto full_size = std::filesystem::file_size(path);
+
+    // Only the dirtied page gets appended this time.
+    proclet.run(&Obj::bump);
+    passed &= (proclet_manager->checkpoint(ids) == 1);
+    passed &= proclet.run(&Obj::check, 1U);
+    passed &= (std::filesystem::file_size(path) > full_size);
+
+    // Until the deltas get compacted into a full record.
+    uint32_t num_bumps = 1;
+    for (uint32_t i = 0; i < ProcletManager::kMaxNumCheckpointDeltas; i++) {
+      proclet.run(&Obj::bump);
+      num_bumps++;
+      passed &= (proclet_manager->checkpoint(ids) == 1);
+    }
+    passed &= (std::filesystem::file_size(path) <= full_size);
+    passed &= proclet.run(&Obj::check, num_bumps);
+
+    // Destroys it without dropping the checkpoint.
+    proclet_manager->set_checkpoint_dir("");
+    proclet.reset();
+    proclet_manager->set_checkpoint_dir(kCheckpointDir);
+
+    auto restored_ids = proclet_manager->restore_checkpoints();
+    passed &= (restored_ids.size() == 1 && restored_ids[0] == id);
+    passed &= (proclet_manager->get_restored_ids() == restored_ids);
+    auto restored = restore_proclet<Obj>(id);
+    passed &= restored.run(&Obj::check, num_bumps);
+    passed &= (to_proclet_header(id)->status() == kPresent);
+    restored.reset();
+    std::filesystem::remove_all(kCheckpointDir);
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}
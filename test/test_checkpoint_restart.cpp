@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+extern "C" {
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/commons.hpp"
+#include "nu/proclet.hpp"
+#include "nu/proclet_mgr.hpp"
+#include "nu/runtime.hpp"
+#include "nu/utils/time.hpp"
+
+using namespace nu;
+
+// Run twice against fresh controllers by test.sh, with each server's
+// --checkpoint_dir under kCheckpointDir and, the second time, with --restore.
+constexpr static uint32_t kNumElems = 4 << 20;
+constexpr static uint32_t kNumBumps = 3;
+constexpr static uint64_t kCapacity = 4 * kDefaultProcletHeapSize;
+constexpr static char kCheckpointDir[] = "/tmp/nu_test_checkpoint_restart";
+
+class Obj {
+ public:
+  Obj() : vec_(kNumElems), stamp_us_(0) {
+    std::iota(vec_.begin(), vec_.end(), 0);
+  }
+  void bump() { vec_[kNumElems / 2]++; }
+  void stamp() { stamp_us_ = Time::microtime(); }
+  bool check(uint32_t num_bumps) {
+    for (uint32_t i = 0; i < kNumElems; i++) {
+      auto expected = i + (i == kNumElems / 2 ? num_bumps : 0);
+      if (vec_[i] != expected) {
+        return false;
+      }
+    }
+    // The logical time resumes from the checkpoint despite the new start_tsc.
+    return stamp_us_ && Time::microtime() >= stamp_us_;
+  }
+
+ private:
+  std::vector<uint32_t> vec_;
+  uint64_t stamp_us_;
+};
+
+// Drives the proclet manager of the node it lives on.
+class Checkpointer {
+ public:
+  uint32_t checkpoint(ProcletID id) {
+    ProcletID ids[] = {id};
+    return get_runtime()->proclet_manager()->checkpoint(ids);
+  }
+  void keep_checkpoints() {
+    get_runtime()->proclet_manager()->set_checkpoint_dir("");
+  }
+  std::vector<ProcletID> get_restored_ids() {
+    return get_runtime()->proclet_manager()->get_restored_ids();
+  }
+};
+
+// Checkpoints a proclet through the manager of its node, then bumps it a few
+// times with a checkpoint after each bump.
+template <typename F>
+bool checkpoint_bumps(Proclet<Obj> *proclet, F checkpoint) {
+  bool passed = true;
+  proclet->run(&Obj::stamp);
+  passed &= (checkpoint(proclet->get_id()) == 1);
+  for (uint32_t i = 0; i < kNumBumps; i++) {
+    proclet->run(&Obj::bump);
+    passed &= (checkpoint(proclet->get_id()) == 1);
+  }
+  return passed;
+}
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    bool passed = true;
+    auto remote_ip = MAKE_IP_ADDR(18, 18, 1, 2);
+    auto *proclet_manager = get_runtime()->proclet_manager();
+    auto &restored_ids = proclet_manager->get_restored_ids();
+    auto checkpointer =
+        make_proclet<Checkpointer>(true, std::nullopt, remote_ip);
+
+    if (restored_ids.empty()) {
+      auto local = make_proclet<Obj>(false, kCapacity, get_cfg_ip());
+      passed &= checkpoint_bumps(&local, [&](ProcletID id) {
+        ProcletID ids[] = {id};
+        return proclet_manager->checkpoint(ids);
+      });
+      // The non-main server restores its own checkpoints while starting up.
+      auto remote = make_proclet<Obj>(false, kCapacity, remote_ip);
+      passed &= checkpoint_bumps(&remote, [&](ProcletID id) {
+        return checkpointer.run(&Checkpointer::checkpoint, id);
+      });
+
+      // Exits without dropping the checkpoints.
+      proclet_manager->set_checkpoint_dir("");
+      checkpointer.run(&Checkpointer::keep_checkpoints);
+      local.reset();
+      remote.reset();
+      std::cout << (passed ? "Checkpointed" : "Failed") << std::endl;
+      return;
+    }
+
+    auto remote_restored_ids =
+        checkpointer.run(&Checkpointer::get_restored_ids);
+    passed &= (restored_ids.size() == 1);
+    passed &= (remote_restored_ids.size() == 1);
+    if (passed) {
+      for (auto [id, ip] : {std::make_pair(restored_ids.front(), get_cfg_ip()),
+                            std::make_pair(remote_restored_ids.front(),
+                                           remote_ip)}) {
+        // The segment has been claimed from the new controller.
+        passed &=
+            (get_runtime()->controller_client()->resolve_proclet(id) == ip);
+        auto restored = restore_proclet<Obj>(id);
+        passed &= restored.run(&Obj::check, kNumBumps);
+      }
+    }
+    checkpointer.reset();
+    std::filesystem::remove_all(kCheckpointDir);
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}
@@ -0,0 +1,70 @@
+#include <cstdint>
+#include <iostream>
+
+extern "C" {
+#include <base/time.h>
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/proclet.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+constexpr static uint32_t kNumCalls = 100;
+constexpr static uint32_t kDelayUs = 20;
+
+class Obj {
+ public:
+  uint64_t slow() {
+    delay_us(kDelayUs);
+    return ++cnt_;
+  }
+  void fast() { cnt_++; }
+
+ private:
+  uint64_t cnt_ = 0;
+};
+
+bool check(Proclet<Obj> &proclet, uint64_t expected_calls) {
+  bool passed = true;
+  bool found_slow = false;
+  bool found_fast = false;
+
+  for (auto &stats : proclet.get_invocation_stats()) {
+    if (stats.method == InvocationStats::to_method_key(&Obj::slow)) {
+      found_slow = true;
+      passed &= (stats.num_calls() == expected_calls);
+      passed &= (stats.execution.mean_ns() >= kDelayUs * 1000);
+      passed &= (stats.execution.percentile_ns(50) >= kDelayUs * 1000);
+    } else if (stats.method == InvocationStats::to_method_key(&Obj::fast)) {
+      found_fast = true;
+      passed &= (stats.num_calls() == expected_calls);
+    }
+  }
+  return passed && (expected_calls == 0 || (found_slow && found_fast));
+}
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    bool passed = true;
+
+    auto proclet = make_proclet<Obj>();
+    proclet.enable_invocation_stats();
+    for (uint32_t i = 0; i < kNumCalls; i++) {
+      proclet.run(&Obj::slow);
+      proclet.run(&Obj::fast);
+    }
+    passed &= check(proclet, kNumCalls);
+
+    proclet.reset_invocation_stats();
+    passed &= check(proclet, 0);
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}
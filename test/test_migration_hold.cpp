@@ -0,0 +1,73 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include <base/time.h>
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/pressure_handler.hpp"
+#include "nu/proclet.hpp"
+#include "nu/rpc_client_mgr.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+// Small enough to be migrated in batches.
+constexpr static uint32_t kNumProclets = 64;
+constexpr static uint64_t kMeasureUs = 2000 * 1000;
+
+class Obj {
+ public:
+  uint32_t inc() { return ++cnt_; }
+  NodeIP where() { return get_cfg_ip(); }
+  void set_pressure() {
+    rt::Preempt p;
+    rt::PreemptGuard g(&p);
+    get_runtime()->pressure_handler()->mock_set_pressure();
+  }
+
+ private:
+  uint32_t cnt_ = 0;
+};
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    bool passed = true;
+    auto ip = MAKE_IP_ADDR(18, 18, 1, 2);
+    std::vector<Proclet<Obj>> proclets;
+    std::vector<uint32_t> cnts(kNumProclets);
+    for (uint32_t i = 0; i < kNumProclets; i++) {
+      proclets.emplace_back(make_proclet<Obj>(false, std::nullopt, ip));
+      passed &= (proclets[i].run(&Obj::inc) == ++cnts[i]);
+    }
+
+    // Calls that land on a migrating proclet are held and then redirected,
+    // whether it is migrated alone or in a batch, so the controller never
+    // gets asked where it went.
+    auto num_resolves = get_runtime()->rpc_client_mgr()->get_num_resolves();
+    proclets[0].run(&Obj::set_pressure);
+    auto start_us = microtime();
+    while (microtime() - start_us < kMeasureUs) {
+      for (uint32_t i = 0; i < kNumProclets; i++) {
+        passed &= (proclets[i].run(&Obj::inc) == ++cnts[i]);
+      }
+    }
+    passed &= (get_runtime()->rpc_client_mgr()->get_num_resolves() ==
+               num_resolves);
+
+    uint32_t num_migrated = 0;
+    for (auto &proclet : proclets) {
+      num_migrated += (proclet.run(&Obj::where) != ip);
+    }
+    passed &= (num_migrated > 0);
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}
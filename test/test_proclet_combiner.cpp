@@ -0,0 +1,58 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/proclet.hpp"
+#include "nu/proclet_combiner.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+constexpr static uint32_t kNumThreads = 100;
+constexpr static uint32_t kNumCallsPerThread = 1000;
+
+class Accumulator {
+ public:
+  uint64_t add(uint64_t delta) { return sum_ += delta; }
+  uint64_t get() { return sum_; }
+
+ private:
+  uint64_t sum_ = 0;
+};
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    auto accumulator = make_proclet<Accumulator>();
+    ProcletCombiner<Accumulator> combiner(accumulator);
+
+    std::vector<Future<void>> futures;
+    for (uint32_t i = 0; i < kNumThreads; i++) {
+      futures.emplace_back(nu::async([&] {
+        for (uint32_t j = 0; j < kNumCallsPerThread; j++) {
+          combiner.run(&Accumulator::add, static_cast<uint64_t>(1));
+        }
+      }));
+    }
+    futures.clear();
+
+    bool passed = true;
+    uint64_t expected = kNumThreads * kNumCallsPerThread;
+    passed &= (combiner.run(&Accumulator::get) == expected);
+    auto ret = combiner.run(
+        +[](Accumulator &a, uint64_t delta) { return a.add(delta); },
+        static_cast<uint64_t>(1));
+    passed &= (ret == expected + 1);
+    passed &= (accumulator.run(&Accumulator::get) == expected + 1);
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}
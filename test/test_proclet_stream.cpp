@@ -0,0 +1,74 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include <base/time.h>
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/pressure_handler.hpp"
+#include "nu/proclet.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+constexpr static uint32_t kNumCalls = 10000;
+
+namespace nu {
+class Test {
+ public:
+  void append(uint32_t x) { log_.push_back(x); }
+  void migrate() {
+    // Set resource pressure using the mock interface
+    {
+      rt::Preempt p;
+      rt::PreemptGuard g(&p);
+      get_runtime()->pressure_handler()->mock_set_pressure();
+    }
+    // Ensure that the migration happens before the function returns.
+    delay_us(1000 * 1000);
+  }
+  std::vector<uint32_t> get_log() { return log_; }
+
+ private:
+  std::vector<uint32_t> log_;
+};
+}  // namespace nu
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    auto proclet = make_proclet<Test>();
+    auto stream = proclet.stream();
+
+    std::vector<Future<void>> futures;
+    for (uint32_t i = 0; i < kNumCalls; i++) {
+      futures.emplace_back(stream.run_async(&Test::append, i));
+      // Calls issued later must wait for the migration to finish.
+      if (i == kNumCalls / 2) {
+        futures.emplace_back(stream.run_async(&Test::migrate));
+      }
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+
+    bool passed = true;
+    auto log = stream.run(&Test::get_log);
+    passed &= (log.size() == kNumCalls);
+    for (uint32_t i = 0; i < log.size(); i++) {
+      passed &= (log[i] == i);
+    }
+    // Overwriting a stream releases its state without blocking.
+    stream = proclet.stream();
+    passed &= (stream.run(&Test::get_log).size() == kNumCalls);
+    stream.reset();
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}
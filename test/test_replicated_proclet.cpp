@@ -0,0 +1,90 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+extern "C" {
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/proclet.hpp"
+#include "nu/replicated_proclet.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+constexpr static uint32_t kNumEntries = 1000;
+
+class Table {
+ public:
+  Table() = default;
+  Table(uint32_t size) : entries_(size) {}
+  void set(uint32_t idx, uint64_t val) { entries_[idx] = val; }
+  uint64_t get(uint32_t idx) const { return entries_[idx]; }
+  uint64_t size() const { return entries_.size(); }
+
+  template <class Archive>
+  void serialize(Archive &ar) {
+    ar(entries_);
+  }
+
+ private:
+  std::vector<uint64_t> entries_;
+};
+
+bool check(ReplicatedProclet<Table> &table, uint64_t delta) {
+  for (uint32_t i = 0; i < kNumEntries; i++) {
+    if (table.run(&Table::get, i) != i + delta) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void do_work() {
+  bool passed = true;
+
+  auto table = make_replicated_proclet<Table>(std::make_tuple(kNumEntries));
+  passed &= (table.run(&Table::size) == kNumEntries);
+
+  for (uint32_t i = 0; i < kNumEntries; i++) {
+    table.run(&Table::set, i, static_cast<uint64_t>(i));
+  }
+  passed &= check(table, 0);
+
+  table.run(
+      +[](Table &t, uint64_t delta) {
+        for (uint32_t i = 0; i < kNumEntries; i++) {
+          t.set(i, t.get(i) + delta);
+        }
+      },
+      static_cast<uint64_t>(1));
+  passed &= check(table, 1);
+
+  // Reads issued from within a proclet go to its local replica, if any.
+  auto proclet = make_proclet<ErasedType>();
+  passed &= proclet.run(
+      +[](ErasedType &, ReplicatedProclet<Table> table) {
+        return check(table, 1);
+      },
+      table);
+
+  // New replicas start from the latest state; retired ones stop serving.
+  auto num_replicas = table.num_replicas();
+  table.add_replica();
+  passed &= (table.num_replicas() == num_replicas + 1);
+  passed &= check(table, 1);
+  table.retire_replica();
+  passed &= (table.num_replicas() == num_replicas);
+  passed &= check(table, 1);
+
+  if (passed) {
+    std::cout << "Passed" << std::endl;
+  } else {
+    std::cout << "Failed" << std::endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) { do_work(); });
+}
@@ -0,0 +1,61 @@
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+extern "C" {
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/commons.hpp"
+#include "nu/proclet.hpp"
+#include "nu/proclet_mgr.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+constexpr static uint32_t kNumElems = 4 << 20;
+
+class Obj {
+ public:
+  Obj() : vec_(kNumElems) { std::iota(vec_.begin(), vec_.end(), 0); }
+  bool check() {
+    for (uint32_t i = 0; i < kNumElems; i++) {
+      if (vec_[i] != i) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::vector<uint32_t> vec_;
+};
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    bool passed = true;
+    auto *proclet_manager = get_runtime()->proclet_manager();
+    proclet_manager->set_spill_dir("/tmp");
+
+    auto proclet = make_proclet<Obj>(false, 64 * kOneMB, get_cfg_ip());
+    passed &= proclet.run(&Obj::check);
+
+    auto *header = to_proclet_header(proclet.get_id());
+    passed &= proclet_manager->spill(header);
+    passed &= (header->status() == kSpilled);
+    passed &= (proclet_manager->get_num_spilled_proclets() == 1);
+
+    // The next invocation reloads it transparently.
+    passed &= proclet.run(&Obj::check);
+    passed &= (header->status() == kPresent);
+    passed &= (proclet_manager->get_num_spilled_proclets() == 0);
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}
@@ -0,0 +1,63 @@
+#include <cstdint>
+#include <iostream>
+#include <set>
+
+extern "C" {
+#include <net/ip.h>
+}
+#include <runtime.h>
+
+#include "nu/proclet.hpp"
+#include "nu/proclet_mgr.hpp"
+#include "nu/runtime.hpp"
+
+using namespace nu;
+
+constexpr static uint32_t kNumRounds = 1000;
+
+class Obj {
+ public:
+  Obj(uint32_t x) : x_(x) {}
+  uint32_t get() { return x_; }
+
+ private:
+  uint32_t x_;
+};
+
+int main(int argc, char **argv) {
+  return runtime_main_init(argc, argv, [](int, char **) {
+    bool passed = true;
+    std::set<ProcletID> ids;
+
+    // Short-lived local proclets should keep reusing the warm heap segments.
+    for (uint32_t i = 0; i < kNumRounds; i++) {
+      auto proclet =
+          make_proclet<Obj>(std::make_tuple(i), false,
+                            ProcletManager::kMaxWarmProcletHeapSize,
+                            get_cfg_ip());
+      passed &= (proclet.run(&Obj::get) == i);
+      ids.insert(proclet.get_id());
+    }
+    passed &= (ids.size() <= ProcletManager::kWarmHeapPoolSize + 1);
+
+    // The ones created without a placement hint are left to the controller,
+    // which cannot hand out the segments that this node keeps warm. Only the
+    // first segment, which was not pooled, may have gone back to it.
+    std::set<ProcletID> reused_ids;
+    for (uint32_t i = 0; i < kNumRounds; i++) {
+      auto proclet = make_proclet<Obj>(std::make_tuple(i), false,
+                                       ProcletManager::kMaxWarmProcletHeapSize);
+      passed &= (proclet.run(&Obj::get) == i);
+      if (ids.contains(proclet.get_id())) {
+        reused_ids.insert(proclet.get_id());
+      }
+    }
+    passed &= (reused_ids.size() <= 1);
+
+    if (passed) {
+      std::cout << "Passed" << std::endl;
+    } else {
+      std::cout << "Failed" << std::endl;
+    }
+  });
+}